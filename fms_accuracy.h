@@ -0,0 +1,548 @@
+// fms_accuracy.h - error and speed of variates and options against a long double reference
+// compare evaluates a double function and a long double reference at n grid points and
+// reports the max and mean absolute and ULP error, the number of NaN results where
+// the reference is finite, and the time per evaluation. The reference namespace has
+// closed forms for the normal, discrete, mixture and Edgeworth models computed with std::
+// long double functions, since ::exp and friends are double only on some compilers.
+// Empirical variates are checked against the discrete reference of their snapshot.
+// Logistic has no reference since its incomplete beta comes from GSL in double.
+// Where long double is double, as with MSVC, the reference only checks the algorithm, not rounding.
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+#include "fms_option.h"
+
+namespace fms::accuracy {
+
+	struct report {
+		std::string name;
+		size_t n; // points compared
+		size_t nan; // NaN where the reference is finite, not in the errors
+		double max_abs, mean_abs;
+		double max_ulp, mean_ulp;
+		double ns; // per evaluation
+	};
+
+	// Units in the last place of double(y) between x and y, with units at least floor
+	// so errors in values near 0 can be measured relative to a scale such as f epsilon.
+	inline double ulp(double x, long double y, double floor = 0) noexcept
+	{
+		if (std::isnan(x) or std::isnan(y)) {
+			return std::isnan(x) and std::isnan(y) ? 0 : std::numeric_limits<double>::infinity();
+		}
+
+		double y_ = std::fabs(static_cast<double>(y));
+		double u = std::nextafter(y_, std::numeric_limits<double>::infinity()) - y_;
+		u = (std::max)(u, floor);
+		if (!(u > 0)) {
+			u = std::numeric_limits<double>::denorm_min();
+		}
+
+		return static_cast<double>(std::fabs(x - y) / u);
+	}
+
+	// Compare f(i) to reference g(i) for i < n, timing reps passes over f.
+	template<class F, class G>
+	inline report compare(std::string name, size_t n, const F& f, const G& g, size_t reps = 1, double floor = 0)
+	{
+		report r{ std::move(name), 0, 0, 0, 0, 0, 0, 0 };
+		std::vector<double> x(n);
+
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t j = 0; j < reps; ++j) {
+			for (size_t i = 0; i < n; ++i) {
+				x[i] = f(i);
+			}
+		}
+		std::chrono::duration<double, std::nano> dt = std::chrono::steady_clock::now() - t0;
+		r.ns = n * reps > 0 ? dt.count() / (n * reps) : 0;
+
+		for (size_t i = 0; i < n; ++i) {
+			long double y = g(i);
+			if (!std::isfinite(y)) {
+				continue;
+			}
+			if (std::isnan(x[i])) {
+				++r.nan;
+				continue;
+			}
+			double e = static_cast<double>(std::fabs(x[i] - y));
+			double u = ulp(x[i], y, floor);
+			++r.n;
+			r.max_abs = (std::max)(r.max_abs, e);
+			r.mean_abs += e;
+			r.max_ulp = (std::max)(r.max_ulp, u);
+			r.mean_ulp += u;
+		}
+		if (r.n) {
+			r.mean_abs /= r.n;
+			r.mean_ulp /= r.n;
+		}
+
+		return r;
+	}
+
+	struct limit {
+		double ulp = std::numeric_limits<double>::infinity(); // max
+		double ns = std::numeric_limits<double>::infinity();
+		size_t nan = 0;
+	};
+	inline bool pass(const report& r, const limit& l) noexcept
+	{
+		return r.max_ulp <= l.ulp and r.ns <= l.ns and r.nan <= l.nan;
+	}
+	// True if r is less accurate than base or slower by more than the slack factors.
+	inline bool regression(const report& r, const report& base, double ulp_slack = 2, double ns_slack = 1.25) noexcept
+	{
+		return r.max_ulp > ulp_slack * (std::max)(base.max_ulp, 1.)
+			or r.mean_ulp > ulp_slack * (std::max)(base.mean_ulp, 1.)
+			or r.ns > ns_slack * base.ns
+			or r.nan > base.nan;
+	}
+
+	// [{"name":...,"n":...,...},...] with null for infinite errors
+	inline std::string json(const std::vector<report>& r)
+	{
+		auto num = [](double x) {
+			char buf[32];
+			if (!std::isfinite(x)) {
+				return std::string("null");
+			}
+			std::snprintf(buf, sizeof(buf), "%.6g", x);
+
+			return std::string(buf);
+		};
+
+		std::string s = "[";
+		for (size_t i = 0; i < r.size(); ++i) {
+			s += (i ? ",{\"name\":\"" : "{\"name\":\"") + r[i].name + "\""
+				+ ",\"n\":" + std::to_string(r[i].n) + ",\"nan\":" + std::to_string(r[i].nan)
+				+ ",\"max_abs\":" + num(r[i].max_abs) + ",\"mean_abs\":" + num(r[i].mean_abs)
+				+ ",\"max_ulp\":" + num(r[i].max_ulp) + ",\"mean_ulp\":" + num(r[i].mean_ulp)
+				+ ",\"ns\":" + num(r[i].ns) + "}";
+		}
+
+		return s + "]";
+	}
+
+	namespace reference {
+
+		using R = long double;
+
+		// standard normal X
+		struct normal {
+			static R phi(R x)
+			{
+				return std::exp(-x * x / 2) / std::sqrt(2 * std::acos(R(-1)));
+			}
+			static R N(R x)
+			{
+				return std::erfc(-x / std::sqrt(R(2))) / 2;
+			}
+
+			R cdf(R x, R s) const
+			{
+				return N(x - s);
+			}
+			R cumulant(R s, size_t n) const
+			{
+				return n == 0 ? s * s / 2 : n == 1 ? s : n == 2 ? 1 : 0;
+			}
+			R edf(R x, R s) const
+			{
+				return -phi(x - s);
+			}
+
+			// call if k > 0, put if k < 0
+			R value(R f, R s, R k) const
+			{
+				R k_ = std::fabs(k);
+				R x = (std::log(k_ / f) + s * s / 2) / s;
+
+				return k > 0 ? f * N(s - x) - k_ * N(-x) : k_ * N(x) - f * N(x - s);
+			}
+			R delta(R f, R s, R k) const
+			{
+				R x = (std::log(std::fabs(k) / f) + s * s / 2) / s;
+
+				return k > 0 ? N(s - x) : -N(x - s);
+			}
+			R gamma(R f, R s, R k) const
+			{
+				R x = (std::log(std::fabs(k) / f) + s * s / 2) / s;
+
+				return phi(x - s) / (f * s);
+			}
+			R vega(R f, R s, R k) const
+			{
+				R x = (std::log(std::fabs(k) / f) + s * s / 2) / s;
+
+				return f * phi(x - s);
+			}
+		};
+
+		// atoms x with probabilities p
+		struct discrete {
+			std::vector<R> x, p;
+
+			template<class M>
+			discrete(const M& m)
+				: x(m.size()), p(m.size())
+			{
+				for (size_t i = 0; i < m.size(); ++i) {
+					x[i] = m.atom(i);
+					p[i] = m.probability(i);
+				}
+			}
+
+			// E[exp(s X) X^n]
+			R e(R s, size_t n) const
+			{
+				R E = 0;
+				for (size_t i = 0; i < x.size(); ++i) {
+					E += std::exp(s * x[i]) * std::pow(x[i], R(n)) * p[i];
+				}
+
+				return E;
+			}
+			R cdf(R x_, R s) const
+			{
+				R P = 0;
+				R e0 = e(s, 0);
+				for (size_t i = 0; i < x.size(); ++i) {
+					if (x[i] <= x_) {
+						P += std::exp(s * x[i]) * p[i] / e0;
+					}
+				}
+
+				return P;
+			}
+			R edf(R x_, R s) const
+			{
+				R D = 0;
+				R e0 = e(s, 0), k1 = e(s, 1) / e0;
+				for (size_t i = 0; i < x.size(); ++i) {
+					if (x[i] <= x_) {
+						D += (x[i] - k1) * std::exp(s * x[i]) * p[i] / e0;
+					}
+				}
+
+				return D;
+			}
+			R cumulant(R s, size_t n) const
+			{
+				R e0 = e(s, 0), e1 = e(s, 1);
+
+				return n == 0 ? std::log(e0) : n == 1 ? e1 / e0 : n == 2 ? e(s, 2) / e0 - e1 * e1 / (e0 * e0) : R(NAN);
+			}
+
+			R value(R f, R s, R k) const
+			{
+				R V = 0, k_ = std::fabs(k), kappa = cumulant(s, 0);
+				for (size_t i = 0; i < x.size(); ++i) {
+					R F = f * std::exp(s * x[i] - kappa);
+					V += p[i] * (k > 0 ? (std::max)(F - k_, R(0)) : (std::max)(k_ - F, R(0)));
+				}
+
+				return V;
+			}
+			R delta(R f, R s, R k) const
+			{
+				R D = 0, k_ = std::fabs(k), kappa = cumulant(s, 0);
+				for (size_t i = 0; i < x.size(); ++i) {
+					R F = std::exp(s * x[i] - kappa);
+					D += p[i] * F * (k > 0 ? f * F > k_ : -(f * F <= k_));
+				}
+
+				return D;
+			}
+			R vega(R f, R s, R k) const
+			{
+				R V = 0, k_ = std::fabs(k), kappa = cumulant(s, 0), kappa1 = cumulant(s, 1);
+				for (size_t i = 0; i < x.size(); ++i) {
+					R F = f * std::exp(s * x[i] - kappa);
+					V += p[i] * F * (x[i] - kappa1) * (F > k_);
+				}
+
+				return V;
+			}
+		};
+
+		// value, delta and vega from cdf, edf and cumulant of the derived reference D
+		template<class D>
+		struct esscher {
+			R moneyness(R f, R s, R k) const
+			{
+				return (std::log(std::fabs(k) / f) + static_cast<const D&>(*this).cumulant(s, 0)) / s;
+			}
+			R value(R f, R s, R k) const
+			{
+				const D& d = static_cast<const D&>(*this);
+				R x = moneyness(f, s, k), k_ = std::fabs(k);
+
+				return k > 0 ? f * (1 - d.cdf(x, s)) - k_ * (1 - d.cdf(x, 0)) : k_ * d.cdf(x, 0) - f * d.cdf(x, s);
+			}
+			R delta(R f, R s, R k) const
+			{
+				R P = static_cast<const D&>(*this).cdf(moneyness(f, s, k), s);
+
+				return k > 0 ? 1 - P : -P;
+			}
+			R vega(R f, R s, R k) const
+			{
+				return -f * static_cast<const D&>(*this).edf(moneyness(f, s, k), s);
+			}
+		};
+
+		// components N(mu_k, sigma_k^2) with weights w_k
+		struct mixture : esscher<mixture> {
+			std::vector<R> w, mu, sigma;
+
+			template<class M>
+			mixture(const M& m)
+				: w(m.size()), mu(m.size()), sigma(m.size())
+			{
+				for (size_t k = 0; k < m.size(); ++k) {
+					w[k] = m.weight(k);
+					mu[k] = m.mean(k);
+					sigma[k] = m.stddev(k);
+				}
+			}
+
+			// Esscher weight of component k
+			R q(size_t k, R s) const
+			{
+				return w[k] * std::exp(mu[k] * s + sigma[k] * sigma[k] * s * s / 2 - cumulant(s, 0));
+			}
+			R cdf(R x, R s) const
+			{
+				R P = 0;
+				for (size_t k = 0; k < w.size(); ++k) {
+					P += q(k, s) * normal::N((x - mu[k]) / sigma[k] - sigma[k] * s);
+				}
+
+				return P;
+			}
+			// E_s[1(X <= x) X] - kappa'(s) cdf(x, s) using truncated normal means
+			R edf(R x, R s) const
+			{
+				R E = 0;
+				for (size_t k = 0; k < w.size(); ++k) {
+					R u = mu[k] + sigma[k] * sigma[k] * s;
+					R z = (x - u) / sigma[k];
+					E += q(k, s) * (u * normal::N(z) - sigma[k] * normal::phi(z));
+				}
+
+				return E - cumulant(s, 1) * cdf(x, s);
+			}
+			R cumulant(R s, size_t n) const
+			{
+				R E = 0, m1 = 0, m2 = 0;
+				for (size_t k = 0; k < w.size(); ++k) {
+					E += w[k] * std::exp(mu[k] * s + sigma[k] * sigma[k] * s * s / 2);
+				}
+				if (n == 0) {
+					return std::log(E);
+				}
+				for (size_t k = 0; k < w.size(); ++k) {
+					R u = mu[k] + sigma[k] * sigma[k] * s;
+					R qk = w[k] * std::exp(mu[k] * s + sigma[k] * sigma[k] * s * s / 2) / E;
+					m1 += qk * u;
+					m2 += qk * (sigma[k] * sigma[k] + u * u);
+				}
+
+				return n == 1 ? m1 : n == 2 ? m2 - m1 * m1 : R(NAN);
+			}
+
+			// Black formula for each component of log F
+			R value(R f, R s, R k) const
+			{
+				R V = 0, k_ = std::fabs(k);
+				for (size_t j = 0; j < w.size(); ++j) {
+					R v = s * sigma[j];
+					R fj = f * q(j, s); // f E[F/f; J = j]
+					R d1 = (std::log(fj / (w[j] * k_)) + v * v / 2) / v;
+					V += k > 0 ? fj * normal::N(d1) - w[j] * k_ * normal::N(d1 - v)
+						: w[j] * k_ * normal::N(v - d1) - fj * normal::N(-d1);
+				}
+
+				return V;
+			}
+			R delta(R f, R s, R k) const
+			{
+				R D = 0, k_ = std::fabs(k);
+				for (size_t j = 0; j < w.size(); ++j) {
+					R v = s * sigma[j];
+					R d1 = (std::log(f * q(j, s) / (w[j] * k_)) + v * v / 2) / v;
+					D += q(j, s) * (k > 0 ? normal::N(d1) : -normal::N(-d1));
+				}
+
+				return D;
+			}
+		};
+
+		// density phi(x) sum_j g_j H_j(x) with g from skew and excess kurtosis
+		struct edgeworth : esscher<edgeworth> {
+			static constexpr size_t N = 7;
+			R g[N];
+
+			template<class M>
+			edgeworth(const M& m)
+				: g{ 1, 0, 0, R(m.skew()) / 6, R(m.kurt()) / 24, 0, R(m.skew()) * R(m.skew()) / 72 }
+			{ }
+
+			// H_0(x), ..., H_{n-1}(x)
+			static void H(size_t n, R x, R* h)
+			{
+				h[0] = 1;
+				if (n > 1) {
+					h[1] = x;
+				}
+				for (size_t j = 2; j < n; ++j) {
+					h[j] = x * h[j - 1] - (j - 1) * h[j - 2];
+				}
+			}
+			// int_{-infty}^y phi(t) sum_{i < n} c_i H_i(t) dt
+			static R integral(size_t n, const R* c, R y)
+			{
+				R h[N + 1];
+				H(n, y, h);
+				R I = c[0] * normal::N(y);
+				for (size_t i = 1; i < n; ++i) {
+					I -= normal::phi(y) * c[i] * h[i - 1];
+				}
+
+				return I;
+			}
+			// g(y + s) = sum_i c_i H_i(y)
+			void shift(R s, R* c) const
+			{
+				for (size_t i = 0; i < N; ++i) {
+					c[i] = 0;
+					R b = 1; // C(j, i)
+					for (size_t j = i; j < N; ++j) {
+						c[i] += g[j] * b * std::pow(s, R(j - i));
+						b = b * (j + 1) / (j + 1 - i);
+					}
+				}
+			}
+			// D^(n)(s) for D(s) = sum_j g_j s^j
+			R D(R s, size_t n) const
+			{
+				R d = 0;
+				for (size_t j = n; j < N; ++j) {
+					R c = g[j];
+					for (size_t l = 0; l < n; ++l) {
+						c *= j - l;
+					}
+					d += c * std::pow(s, R(j - n));
+				}
+
+				return d;
+			}
+
+			R cdf(R x, R s) const
+			{
+				R c[N];
+				shift(s, c);
+
+				return integral(N, c, x - s) / D(s, 0);
+			}
+			// E_s[1(X <= x) X] using (y + s) H_i(y) = H_{i+1}(y) + i H_{i-1}(y) + s H_i(y)
+			R edf(R x, R s) const
+			{
+				R c[N], e[N + 1];
+				shift(s, c);
+				for (size_t i = 0; i <= N; ++i) {
+					e[i] = (i < N ? s * c[i] : 0) + (i > 0 ? c[i - 1] : 0) + (i + 1 < N ? (i + 1) * c[i + 1] : 0);
+				}
+
+				return integral(N + 1, e, x - s) / D(s, 0) - cumulant(s, 1) * cdf(x, s);
+			}
+			R cumulant(R s, size_t n) const
+			{
+				R d = D(s, 0), d1 = D(s, 1) / d;
+
+				return n == 0 ? s * s / 2 + std::log(d) : n == 1 ? s + d1 : n == 2 ? 1 + D(s, 2) / d - d1 * d1 : R(NAN);
+			}
+		};
+
+	}
+
+	// cdf(x, s), cumulant(s, n), n < 3, and edf(x, s) if both have it, of m on an x by s grid
+	template<class M, class Ref>
+	inline std::vector<report> variate(const M& m, const Ref& ref, size_t nx, const double* x, size_t ns, const double* s, size_t reps = 1)
+	{
+		std::vector<report> r;
+
+		r.push_back(compare("cdf", nx * ns,
+			[&](size_t i) { return double(m.cdf(x[i % nx], s[i / nx], 0)); },
+			[&](size_t i) { return ref.cdf(x[i % nx], s[i / nx]); }, reps));
+		for (size_t n : { 0, 1, 2 }) {
+			r.push_back(compare("cumulant" + std::string(n, '\''), ns,
+				[&](size_t i) { return double(m.cumulant(s[i], n)); },
+				[&](size_t i) { return ref.cumulant(s[i], n); }, reps));
+		}
+		if constexpr (requires { m.edf(x[0], s[0]); ref.edf(x[0], s[0]); }) {
+			// edf is a difference of terms near 1 in the body
+			r.push_back(compare("edf", nx * ns,
+				[&](size_t i) { return double(m.edf(x[i % nx], s[i / nx])); },
+				[&](size_t i) { return ref.edf(x[i % nx], s[i / nx]); }, reps, std::numeric_limits<double>::epsilon()));
+		}
+
+		return r;
+	}
+
+	// Value and greeks of o on an s by k grid at forward f, negative strikes for puts,
+	// and implied vols of the reference values. Greeks the reference lacks are skipped.
+	template<class M, class Ref>
+	inline std::vector<report> option(const fms::option<M>& o, const Ref& ref, double f,
+		size_t ns, const double* s, size_t nk, const double* k, size_t reps = 1)
+	{
+		std::vector<report> r;
+		size_t n = ns * nk;
+		double eps = std::numeric_limits<double>::epsilon(); // smallest units relative to f or 1
+		auto S = [&](size_t i) { return s[i / nk]; };
+		auto K = [&](size_t i) { return k[i % nk]; };
+
+		r.push_back(compare("value", n,
+			[&](size_t i) { return double(o.value(f, S(i), K(i))); },
+			[&](size_t i) { return ref.value(f, S(i), K(i)); }, reps, f * eps));
+		if constexpr (requires { ref.delta(f, f, f); }) {
+			r.push_back(compare("delta", n,
+				[&](size_t i) { return double(o.delta(f, S(i), K(i))); },
+				[&](size_t i) { return ref.delta(f, S(i), K(i)); }, reps, eps));
+		}
+		if constexpr (requires { ref.gamma(f, f, f); }) {
+			r.push_back(compare("gamma", n,
+				[&](size_t i) { return double(o.gamma(f, S(i), K(i))); },
+				[&](size_t i) { return ref.gamma(f, S(i), K(i)); }, reps, eps / f));
+		}
+		if constexpr (requires { ref.vega(f, f, f); }) {
+			r.push_back(compare("vega", n,
+				[&](size_t i) { return double(o.vega(f, S(i), K(i))); },
+				[&](size_t i) { return ref.vega(f, S(i), K(i)); }, reps, f * eps));
+		}
+
+		// implied vol of the rounded reference value should return the vol
+		std::vector<double> v(n);
+		for (size_t i = 0; i < n; ++i) {
+			v[i] = double(ref.value(f, S(i), K(i)));
+		}
+		r.push_back(compare("implied", n,
+			[&](size_t i) {
+				double k_ = K(i), s_ = 0;
+				o.implied(f, 1, &k_, &v[i], &s_);
+				return s_;
+			},
+			[&](size_t i) { return (long double)S(i); }, reps, eps));
+
+		return r;
+	}
+
+}
@@ -0,0 +1,146 @@
+// fms_accuracy.t.cpp - test accuracy harness
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "fms_accuracy.h"
+#include "fms_variate_discrete.h"
+#include "fms_variate_edgeworth.h"
+#include "fms_variate_empirical.h"
+#include "fms_variate_mixture.h"
+#include "fms_variate_normal.h"
+
+using namespace fms;
+
+int test_accuracy()
+{
+	assert(accuracy::ulp(1., 1.L) == 0);
+	assert(accuracy::ulp(std::nextafter(1., 2.), 1.L) == 1);
+	assert(std::isinf(accuracy::ulp(NAN, 1.L)));
+
+	std::vector<double> s, k, x;
+	for (double s_ = 0.05; s_ < 1; s_ += 0.05) {
+		s.push_back(s_);
+	}
+	for (double k_ = 50; k_ <= 200; k_ += 5) {
+		k.push_back(k_ < 100 ? -k_ : k_);
+	}
+	for (double x_ = -4; x_ <= 4; x_ += 0.25) {
+		x.push_back(x_);
+	}
+
+	{
+		variate::normal_impl<> N;
+		option o(N);
+		accuracy::reference::normal ref;
+
+		auto v = accuracy::variate(N, ref, x.size(), x.data(), s.size(), s.data());
+		assert(v.size() == 5 and v[4].name == "edf");
+		for (const auto& r : v) {
+			assert(r.nan == 0);
+			assert(r.max_abs < 1e-15);
+		}
+		assert(v[4].max_ulp < 2);
+
+		auto r = accuracy::option(o, ref, 100, s.size(), s.data(), k.size(), k.data());
+		assert(r.size() == 5 and r[0].name == "value" and r[4].name == "implied");
+		assert(r[0].n == s.size() * k.size());
+		for (size_t i = 0; i < 4; ++i) {
+			assert(r[i].max_abs < 1e-10);
+			assert(r[i].max_ulp < 64 and r[i].mean_ulp < 1);
+			assert(r[i].ns > 0);
+		}
+		// implied vols of values near 0 in the wings are ill conditioned
+		assert(r[4].n + r[4].nan == r[0].n and r[4].mean_abs < 1e-3);
+		double k_[] = { -90, 100, 110 };
+		auto r_ = accuracy::option(o, ref, 100, s.size(), s.data(), 3, k_);
+		assert(r_[4].nan == 0 and r_[4].max_abs < 1e-8);
+
+		// an error of one ulp in every value shows up
+		auto worse = accuracy::compare("value", k.size(),
+			[&](size_t i) { double v_ = double(ref.value(100, 0.2, k[i])); return std::nextafter(v_, 2 * v_); },
+			[&](size_t i) { return ref.value(100, 0.2, k[i]); });
+		auto base = accuracy::compare("value", k.size(),
+			[&](size_t i) { return double(ref.value(100, 0.2, k[i])); },
+			[&](size_t i) { return ref.value(100, 0.2, k[i]); });
+		assert(base.max_ulp <= 0.5 and worse.max_ulp >= 0.5);
+		worse.max_ulp += 2;
+		assert(accuracy::regression(worse, base));
+		assert(!accuracy::regression(base, base, 2, 1e9));
+		assert(accuracy::pass(base, accuracy::limit{ 1 }));
+		assert(!accuracy::pass(worse, accuracy::limit{ 1 }));
+
+		auto json = accuracy::json(r);
+		assert(json.front() == '[' and json.back() == ']');
+		assert(json.find("\"name\":\"implied\"") != std::string::npos);
+	}
+	{
+		variate::discrete<> D({ -1, 0, 2 }, { 0.25, 0.5, 0.25 });
+		option o(D);
+		accuracy::reference::discrete ref(D);
+
+		auto v = accuracy::variate(D, ref, x.size(), x.data(), s.size(), s.data());
+		for (const auto& r : v) {
+			assert(r.nan == 0 and r.max_abs < 1e-14);
+		}
+		auto r = accuracy::option(o, ref, 100, s.size(), s.data(), k.size(), k.data());
+		assert(r.size() == 4 and r[1].name == "delta" and r[2].name == "vega");
+		assert(r[0].max_abs < 1e-12 and r[1].max_abs < 1e-14 and r[2].max_abs < 1e-12);
+	}
+	{
+		variate::mixture<double, double, 3> m({ 0.2, 0.5, 0.3 }, { -1, 0, 0.5 }, { 1.5, 0.8, 1 });
+		option o(m);
+		accuracy::reference::mixture ref(m);
+
+		auto v = accuracy::variate(m, ref, x.size(), x.data(), s.size(), s.data());
+		assert(v.size() == 5);
+		for (const auto& r : v) {
+			assert(r.nan == 0 and r.max_abs < 1e-14);
+		}
+		auto r = accuracy::option(o, ref, 100, s.size(), s.data(), k.size(), k.data());
+		assert(r.size() == 4 and r[2].name == "vega");
+		for (size_t i = 0; i < 3; ++i) {
+			assert(r[i].nan == 0 and r[i].max_ulp < 64);
+		}
+	}
+	{
+		variate::edgeworth<> e(-0.3, 0.5);
+		option o(e);
+		accuracy::reference::edgeworth ref(e);
+
+		auto v = accuracy::variate(e, ref, x.size(), x.data(), s.size(), s.data());
+		assert(v.size() == 5);
+		for (const auto& r : v) {
+			assert(r.nan == 0 and r.max_abs < 1e-14);
+		}
+		auto r = accuracy::option(o, ref, 100, s.size(), s.data(), k.size(), k.data());
+		for (size_t i = 0; i < 3; ++i) {
+			assert(r[i].nan == 0 and r[i].max_ulp < 64);
+		}
+	}
+	{
+		// empirical against the discrete reference of its snapshot
+		double y[21];
+		for (int i = 0; i < 21; ++i) {
+			y[i] = (i - 10) / 100.;
+		}
+		variate::empirical<> e(21, y);
+		for (double y_ : { 0.02, -0.01, 0.03, 0., -0.05, 0.01, 0.01, -0.02 }) {
+			e.add(y_);
+		}
+		option o(e);
+		accuracy::reference::discrete ref(e.model());
+
+		auto v = accuracy::variate(e, ref, x.size(), x.data(), s.size(), s.data());
+		assert(v.size() == 5);
+		for (const auto& r : v) {
+			assert(r.nan == 0 and r.max_abs < 1e-14);
+		}
+		auto r = accuracy::option(o, ref, 100, s.size(), s.data(), k.size(), k.data());
+		for (size_t i = 0; i < 3; ++i) {
+			assert(r[i].nan == 0 and r[i].max_ulp < 64);
+		}
+	}
+
+	return 0;
+}
+int test_accuracy_ = test_accuracy();
@@ -0,0 +1,106 @@
+// fms_arbitrage.h - static arbitrage screen of quote chains
+// Quotes are sorted by strike with negative strike for put and converted to call
+// values c(k) using parity c = p + f - k. A chain is free of static arbitrage if
+// (f - k)^+ <= c(k) <= f, c is decreasing with slope at least -1, and c is convex.
+// Calls at the same moneyness k/f are increasing in expiry after dividing by f.
+// Each check is a branch free loop over contiguous arrays so it vectorizes.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "fms_ensure.h"
+
+namespace fms::arbitrage {
+
+	enum flag : unsigned char {
+		none = 0,
+		lower = 1 << 0,    // below intrinsic value
+		upper = 1 << 1,    // call above f or put above k
+		monotone = 1 << 2, // call spread with the previous strike not in [0, k - k_]
+		convex = 1 << 3,   // butterfly centred at the strike is negative
+		calendar = 1 << 4, // above a later expiry at the same moneyness
+	};
+
+	// Call values c and positive strikes k from n quotes with strike k_, negative for put.
+	template<class X>
+	inline void call_value(X f, size_t n, const X* k_, const X* v, X* k, X* c) noexcept
+	{
+		for (size_t i = 0; i < n; ++i) {
+			k[i] = ::fabs(k_[i]);
+			c[i] = v[i] + X(k_[i] < 0) * (f - k[i]);
+		}
+	}
+
+	// Set flags of n quotes sorted by strike with values v at forward f.
+	// Prices within tol of a bound pass. Returns the number of flagged quotes.
+	template<class X>
+	inline size_t screen(X f, size_t n, const X* k_, const X* v, unsigned char* flags, X tol = 0)
+	{
+		std::vector<X> k_c(2 * n);
+		X* k = k_c.data(); // raw pointers since flags may alias vector internals
+		X* c = k + n;
+		call_value(f, n, k_, v, k, c);
+		ensure(std::is_sorted(k, k + n));
+
+		for (size_t i = 0; i < n; ++i) {
+			X ki = k[i], ci = c[i];
+			flags[i] = static_cast<unsigned char>(
+				lower * (ci < (std::max)(f - ki, X(0)) - tol)
+				| upper * (ci > f + tol));
+		}
+		// c_{i-1} - c_i in [0, k_i - k_{i-1}]
+		for (size_t i = 1; i < n; ++i) {
+			X dc = c[i - 1] - c[i];
+			flags[i] |= static_cast<unsigned char>(monotone * ((dc < -tol) | (dc > k[i] - k[i - 1] + tol)));
+		}
+		// (c_i - c_{i-1})/(k_i - k_{i-1}) <= (c_{i+1} - c_i)/(k_{i+1} - k_i)
+		for (size_t i = 1; i + 1 < n; ++i) {
+			X d0 = k[i] - k[i - 1];
+			X d1 = k[i + 1] - k[i];
+			X b = (c[i - 1] - c[i]) * d1 - (c[i] - c[i + 1]) * d0; // butterfly times d0 d1
+			flags[i] |= static_cast<unsigned char>(convex * (b < -tol * (d0 + d1)));
+		}
+
+		size_t m = 0;
+		for (size_t i = 0; i < n; ++i) {
+			m += flags[i] != none;
+		}
+
+		return m;
+	}
+
+	// Flag quotes of the chain expiring first at forward f0 if c0/f0 exceeds the later chain's
+	// c1/f1 at the same moneyness k/f. Since c1 is convex, linear interpolation of the later
+	// chain is an upper bound so flagged quotes violate calendar arbitrage.
+	// Quotes outside the later chain's strikes are not checked. Returns the number flagged.
+	template<class X>
+	inline size_t screen(X f0, size_t n0, const X* k0_, const X* v0, unsigned char* flags0,
+		X f1, size_t n1, const X* k1_, const X* v1, X tol = 0)
+	{
+		std::vector<X> k0(n0), c0(n0), k1(n1), c1(n1);
+		call_value(f0, n0, k0_, v0, k0.data(), c0.data());
+		call_value(f1, n1, k1_, v1, k1.data(), c1.data());
+		ensure(std::is_sorted(k0.begin(), k0.end()));
+		ensure(std::is_sorted(k1.begin(), k1.end()));
+
+		size_t m = 0;
+		size_t j = 0;
+		for (size_t i = 0; i < n0; ++i) {
+			X z = k0[i] * f1 / f0; // same moneyness at the later expiry
+			while (j + 1 < n1 and k1[j + 1] < z) {
+				++j;
+			}
+			if (j + 1 < n1 and k1[j] <= z) {
+				X u = (z - k1[j]) / (k1[j + 1] - k1[j]);
+				X c = c1[j] + u * (c1[j + 1] - c1[j]);
+				bool a = c0[i] / f0 > c / f1 + tol / f0;
+				flags0[i] |= static_cast<unsigned char>(calendar * a);
+				m += a;
+			}
+		}
+
+		return m;
+	}
+
+}
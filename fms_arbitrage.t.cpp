@@ -0,0 +1,82 @@
+// fms_arbitrage.t.cpp - test static arbitrage screen
+#include <cassert>
+#include <cmath>
+#include "fms_variate_normal.h"
+#include "fms_option.h"
+#include "fms_arbitrage.h"
+
+using namespace fms;
+
+template<class X = double>
+int test_arbitrage()
+{
+	constexpr size_t n = 11;
+	variate::normal_impl<X> N;
+	option o(N);
+	X f = 100;
+	X k[n], v[n];
+	unsigned char flags[n];
+
+	for (size_t i = 0; i < n; ++i) {
+		k[i] = X(75 + 5 * i);
+		if (k[i] < f) {
+			k[i] = -k[i];
+		}
+		v[i] = o.value(f, X(0.2), k[i]);
+	}
+	{
+		assert(0 == arbitrage::screen(f, n, k, v, flags));
+		for (size_t i = 0; i < n; ++i) {
+			assert(flags[i] == arbitrage::none);
+		}
+	}
+	{
+		X v_[n];
+		std::copy(v, v + n, v_);
+		v_[0] = X(-0.1);
+		arbitrage::screen(f, n, k, v_, flags);
+		assert(flags[0] & arbitrage::lower);
+
+		// call value increasing in strike
+		std::copy(v, v + n, v_);
+		v_[n - 1] = v_[n - 2] + X(0.01);
+		arbitrage::screen(f, n, k, v_, flags);
+		assert(flags[n - 1] & arbitrage::monotone);
+
+		std::copy(v, v + n, v_);
+		v_[n - 1] = f + 1;
+		arbitrage::screen(f, n, k, v_, flags);
+		assert(flags[n - 1] & arbitrage::upper);
+
+		// drop one quote so the butterflies on either side are negative
+		std::copy(v, v + n, v_);
+		v_[5] -= 1;
+		assert(2 == arbitrage::screen(f, n, k, v_, flags));
+		assert(flags[4] & arbitrage::convex);
+		assert(!(flags[5] & arbitrage::convex));
+		assert(flags[6] & arbitrage::convex);
+		// tolerance
+		assert(0 == arbitrage::screen(f, n, k, v_, flags, X(1)));
+	}
+	{
+		// later expiry with higher vol is fine, lower vol is not
+		X f1 = 102;
+		X k1[n], v1[n];
+		for (size_t i = 0; i < n; ++i) {
+			k1[i] = X(70 + 6 * i);
+			v1[i] = o.value(f1, X(0.3), k1[i]);
+		}
+		std::fill(flags, flags + n, arbitrage::none);
+		assert(0 == arbitrage::screen(f, n, k, v, flags, f1, n, k1, v1));
+
+		for (size_t i = 0; i < n; ++i) {
+			v1[i] = o.value(f1, X(0.1), k1[i]);
+		}
+		size_t m = arbitrage::screen(f, n, k, v, flags, f1, n, k1, v1);
+		assert(m > 0);
+		assert(flags[5] & arbitrage::calendar);
+	}
+
+	return 0;
+}
+int test_arbitrage_d = test_arbitrage<double>();
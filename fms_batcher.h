@@ -0,0 +1,220 @@
+// fms_batcher.h - coalesce concurrent pricing requests into batches
+// Callers submit records from any thread and get a future, or a callback run on the worker.
+// One worker drains the queue into batches of up to max requests, lingering briefly for a
+// batch to fill, and sorts each batch by measure, forward, vol and strike so price::price
+// sees strips. Implied requests are sorted by forward and strike, since their vol field is
+// the option value, so chains warm start from strike neighbours.
+// Models are held in versioned so a calibrator can publish new ones while pricing.
+// Each result carries the model version used and its latency from submit to completion.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_price.h"
+#include "fms_versioned.h"
+
+namespace fms {
+
+	template<class M>
+	class batcher {
+	public:
+		using clock = std::chrono::steady_clock;
+		struct result {
+			double value;
+			uint64_t version; // of the model used
+			std::chrono::nanoseconds latency;
+		};
+		struct stats {
+			uint64_t requests;
+			uint64_t batches;
+			std::chrono::nanoseconds latency; // total
+			std::chrono::nanoseconds latency_max;
+		};
+	private:
+		struct request {
+			price::record r;
+			price::measure w;
+			clock::time_point t;
+			std::promise<result> p;
+			std::function<void(const result&)> done; // instead of p if set
+		};
+
+		versioned<M> m;
+		size_t max;
+		std::chrono::microseconds linger;
+
+		std::mutex mx;
+		std::condition_variable cv;
+		std::deque<request> queue;
+		bool stop;
+
+		std::atomic<uint64_t> requests, batches, latency, latency_max;
+		std::thread worker;
+
+		void push(request&& q)
+		{
+			size_t n;
+			{
+				std::lock_guard<std::mutex> lock(mx);
+				ensure(!stop);
+				queue.push_back(std::move(q));
+				n = queue.size();
+			}
+			// wake the worker for a new batch or a full one
+			if (n == 1 or n == max) {
+				cv.notify_one();
+			}
+		}
+
+		void run()
+		{
+			typename versioned<M>::reader reader(m);
+			std::vector<request> batch;
+			std::vector<size_t> i;
+			std::vector<price::record> r;
+			std::vector<double> v;
+
+			while (true) {
+				{
+					std::unique_lock<std::mutex> lock(mx);
+					cv.wait(lock, [this] { return stop or !queue.empty(); });
+					if (queue.empty()) {
+						return; // stopped and drained
+					}
+					if (queue.size() < max and !stop) {
+						cv.wait_for(lock, linger, [this] { return stop or queue.size() >= max; });
+					}
+
+					size_t n = (std::min)(max, queue.size());
+					batch.clear();
+					for (size_t j = 0; j < n; ++j) {
+						batch.push_back(std::move(queue.front()));
+						queue.pop_front();
+					}
+				}
+
+				size_t n = batch.size();
+				i.resize(n);
+				std::iota(i.begin(), i.end(), size_t(0));
+				std::sort(i.begin(), i.end(), [&batch](size_t a, size_t b) {
+					const auto& ra = batch[a];
+					const auto& rb = batch[b];
+					if (ra.w != rb.w) {
+						return ra.w < rb.w;
+					}
+					if (ra.r.f != rb.r.f) {
+						return ra.r.f < rb.r.f;
+					}
+					if (ra.w != price::measure::implied and ra.r.s != rb.r.s) {
+						return ra.r.s < rb.r.s;
+					}
+
+					// puts have negative strike
+					return std::fabs(ra.r.k) < std::fabs(rb.r.k);
+				});
+				r.resize(n);
+				v.resize(n);
+				for (size_t j = 0; j < n; ++j) {
+					r[j] = batch[i[j]].r;
+				}
+
+				auto s = reader.read();
+				option o(*s);
+				for (size_t j = 0; j < n; ) {
+					price::measure w = batch[i[j]].w;
+					size_t l = j + 1;
+					while (l < n and batch[i[l]].w == w) {
+						++l;
+					}
+					price::price(o, w, l - j, r.data() + j, v.data() + j);
+					j = l;
+				}
+
+				// statistics include this batch before any caller sees its result
+				auto t = clock::now();
+				uint64_t total = 0, tmax = latency_max.load(std::memory_order_relaxed);
+				for (size_t j = 0; j < n; ++j) {
+					uint64_t dt = std::chrono::duration_cast<std::chrono::nanoseconds>(t - batch[i[j]].t).count();
+					total += dt;
+					tmax = (std::max)(tmax, dt);
+				}
+				requests += n;
+				++batches;
+				latency += total;
+				latency_max.store(tmax, std::memory_order_relaxed);
+
+				for (size_t j = 0; j < n; ++j) {
+					auto& q = batch[i[j]];
+					result res{ v[j], s.version(), std::chrono::duration_cast<std::chrono::nanoseconds>(t - q.t) };
+					if (q.done) {
+						q.done(res);
+					}
+					else {
+						q.p.set_value(res);
+					}
+				}
+			}
+		}
+	public:
+		// At most max requests per batch, waiting up to linger for a batch to fill.
+		batcher(M m, size_t max = price::block, std::chrono::microseconds linger = std::chrono::microseconds(50))
+			: m(std::move(m)), max(max), linger(linger), stop(false),
+			requests(0), batches(0), latency(0), latency_max(0)
+		{
+			ensure(max > 0);
+
+			worker = std::thread([this] { run(); });
+		}
+		batcher(const batcher&) = delete;
+		batcher& operator=(const batcher&) = delete;
+		// Pending requests are completed before returning.
+		~batcher()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mx);
+				stop = true;
+			}
+			cv.notify_one();
+			worker.join();
+		}
+
+		std::future<result> submit(const price::record& r, price::measure w = price::measure::value)
+		{
+			std::promise<result> p;
+			auto f = p.get_future();
+			push(request{ r, w, clock::now(), std::move(p), nullptr });
+
+			return f;
+		}
+		// Call done on the worker thread with latency measured from t, e.g. when a
+		// remote caller sent the request. done must not throw or block for long.
+		void submit(const price::record& r, price::measure w, std::function<void(const result&)> done, clock::time_point t = clock::now())
+		{
+			push(request{ r, w, t, std::promise<result>{}, std::move(done) });
+		}
+
+		// Replace the model used by later batches.
+		uint64_t publish(M m_)
+		{
+			return m.publish(std::move(m_));
+		}
+
+		stats statistics() const
+		{
+			return stats{ requests.load(), batches.load(),
+				std::chrono::nanoseconds(latency.load()), std::chrono::nanoseconds(latency_max.load()) };
+		}
+	};
+
+}
@@ -0,0 +1,107 @@
+// fms_batcher.t.cpp - test micro batching of pricing requests
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "fms_variate_discrete.h"
+#include "fms_batcher.h"
+
+using namespace fms;
+
+int test_batcher()
+{
+	using model = variate::discrete<double, double, 2>;
+	model m0({ -1, 1 }, { 0.5, 0.5 });
+	model m1({ -2, 0.5 }, { 0.2, 0.8 });
+	option o0(m0);
+	option o1(m1);
+	using price::kind;
+	using price::measure;
+
+	{
+		batcher<model> b(m0, 64);
+		constexpr size_t n = 200;
+		std::vector<std::thread> t;
+		std::vector<int> ok(4, 0);
+
+		for (int j = 0; j < 4; ++j) {
+			t.emplace_back([&, j] {
+				std::vector<std::future<batcher<model>::result>> f;
+				std::vector<price::record> r;
+				for (size_t i = 0; i < n; ++i) {
+					double k = 90 + (i * 7 + j) % 21;
+					r.push_back({ 100, 0.1 + 0.1 * (i % 3), k < 100 ? -k : k, kind::vanilla, 0 });
+					f.push_back(b.submit(r.back(), j == 3 ? measure::delta : measure::value));
+				}
+				for (size_t i = 0; i < n; ++i) {
+					auto v = f[i].get();
+					double v_ = price::price(o0, j == 3 ? measure::delta : measure::value, r[i]);
+					ok[j] += v.value == v_ and v.version == 1 and v.latency.count() >= 0;
+				}
+			});
+		}
+		for (auto& t_ : t) {
+			t_.join();
+		}
+		for (int j = 0; j < 4; ++j) {
+			assert(ok[j] == n);
+		}
+
+		auto s = b.statistics();
+		assert(s.requests == 4 * n);
+		assert(s.batches >= (4 * n) / 64 and s.batches <= 4 * n);
+		assert(s.latency_max <= s.latency);
+
+		// later batches use the new model
+		assert(b.publish(m1) == 2);
+		price::record r{ 100, 0.2, 100, kind::digital_call, 0 };
+		auto v = b.submit(r).get();
+		assert(v.version == 2);
+		assert(v.value == price::price(o1, measure::value, r));
+	}
+	{
+		// implied requests in unsorted strike order with callbacks
+		batcher<model> b(m0, 256, std::chrono::microseconds(1000));
+		constexpr size_t n = 200;
+		std::vector<price::record> r;
+		std::vector<double> v(n);
+		std::atomic<size_t> got = 0;
+		auto t = batcher<model>::clock::now();
+		for (size_t i = 0; i < n; ++i) {
+			double k = 80 + (i * 7) % 41;
+			r.push_back({ 100, 0, k, kind::vanilla, 0 });
+			r.back().s = o0.value(100., 0.1 * (1 + i % 3), k);
+			b.submit(r.back(), measure::implied, [&, i](const batcher<model>::result& res) {
+				v[i] = res.value;
+				++got;
+			}, t);
+		}
+		while (got < n) {
+			std::this_thread::yield();
+		}
+		for (size_t i = 0; i < n; ++i) {
+			// no time value, no vol
+			if (r[i].s > std::max(100 - r[i].k, 0.)) {
+				assert(fabs(o0.value(100., v[i], r[i].k) - r[i].s) < 1e-8);
+			}
+			else {
+				assert(std::isnan(v[i]));
+			}
+		}
+		assert(b.statistics().batches < n);
+	}
+	{
+		// destructor completes pending requests
+		std::future<batcher<model>::result> f;
+		{
+			batcher<model> b(m0, 1024, std::chrono::microseconds(100000));
+			f = b.submit({ 100, 0.2, 100, kind::vanilla, 0 });
+		}
+		assert(f.get().value == o0.value(100., 0.2, 100.));
+	}
+
+	return 0;
+}
+int test_batcher_ = test_batcher();
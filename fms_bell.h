@@ -1,9 +1,16 @@
 // fms_bell.h - Bell polynomials
+// Incomplete Bell polynomials B_{n,k}(x_1, ..., x_{n - k + 1}) satisfy
+// B_{n,k} = sum_{i=1}^{n-k+1} C(n - 1, i - 1) x_i B_{n-i,k-1}
+// with B_{0,0} = 1, B_{n,0} = 0 and B_{0,k} = 0 if n,k > 0.
+// Complete Bell polynomials B_n = sum_k B_{n,k} take cumulants to moments:
+// m_n = B_n(kappa_1, ..., kappa_n) and B_{n+1} = sum_{i=0}^n C(n, i) B_{n-i} x_{i+1}.
 #pragma once
+#include <cstddef>
+#include <limits>
 
 namespace fms {
 
-	inline long choose(long n, long k)
+	inline constexpr unsigned long long choose(size_t n, size_t k)
 	{
 		if (k > n) {
 			return 0;
@@ -13,43 +20,125 @@ namespace fms {
 			k = n - k;
 		}
 
-		long cnk = 1; // use ((n/1)(n-1)/2 ... (n - k + 1)/k
-		for (long j = 1; j <= k; ++j, --n) {
+		unsigned long long cnk = 1; // use ((n/1)(n-1)/2 ... (n - k + 1)/k
+		for (size_t j = 1; j <= k; ++j, --n) {
 			cnk *= n;
 			cnk /= j;
 		}
 
-		return cnk
-	)
+		return cnk;
+	}
+
+	// Maximum order of Bell polynomials and moment/cumulant conversions.
+	inline constexpr size_t BELL_MAX = 32;
+
+	// Pascal's triangle computed at compile time
+	template<size_t N = BELL_MAX>
+	struct binomial_table {
+		unsigned long long c[N][N];
+
+		constexpr binomial_table()
+			: c{}
+		{
+			for (size_t n = 0; n < N; ++n) {
+				c[n][0] = 1;
+				for (size_t k = 1; k <= n; ++k) {
+					c[n][k] = c[n - 1][k - 1] + (k < n ? c[n - 1][k] : 0);
+				}
+			}
+		}
+		constexpr unsigned long long operator()(size_t n, size_t k) const
+		{
+			return c[n][k];
+		}
+	};
+	inline constexpr binomial_table<> binomial{};
 
 	// Incomplete Bell polynomials
-	// B_{n,k}(x_1, ..., x_{n - k +1})
-	// B_{n,k} = 1/(x_1 (n - k)) sum_{j=1}^{n-k} c(n, j) (k + 1 - (n + 1)/(j + 1)) x_{j+1} B_{n-j,k}
-	// B_{0,0} = 1, B_{n,0} = 0, B_{0,k} = 0 if n,k > 0
-	// Returns B_{1,k}, ... , B_{n,k} in B
+	// B[m * (n + 1) + k] = B_{m,k}(x_1, ..., x_{m - k + 1}) for 0 <= k <= m <= n < BELL_MAX
+	// where x[0] = x_1. B has (n + 1)^2 entries.
 	template<class X = double>
-	inline constexpr X Bell(size_t n, size_t k, const X* x, X* B)
+	inline constexpr void Bell(size_t n, const X* x, X* B)
 	{
-		if (n == 0 and k == 0) {
-			return 1;
+		size_t n1 = n + 1;
+
+		for (size_t i = 0; i < n1 * n1; ++i) {
+			B[i] = X(0);
 		}
-		else if (n == 0) {
-			return 0;
+		B[0] = X(1);
+		for (size_t m = 1; m <= n; ++m) {
+			for (size_t k = 1; k <= m; ++k) {
+				X b = 0;
+				for (size_t i = 1; i <= m - k + 1; ++i) {
+					b += X(binomial(m - 1, i - 1)) * x[i - 1] * B[(m - i) * n1 + k - 1];
+				}
+				B[m * n1 + k] = b;
+			}
 		}
-		else if (k == 0) {
-			return 0;
+	}
+
+	// Complete Bell polynomial B_n(x_1, ..., x_n)
+	template<class X = double>
+	inline constexpr X Bell(size_t n, const X* x)
+	{
+		if (n >= BELL_MAX) {
+			return std::numeric_limits<X>::quiet_NaN();
 		}
 
-		for (j = 1; j < n - k; ++j) {
-			B[j - 1] = 1 / (x[0] * (n - k)) choose(n, j) (k + 1 - (n + 1) / (j + 1)) * x[j] * Bell(n - j - 1, k);
+		X B[BELL_MAX] = { X(1) };
+		for (size_t j = 0; j < n; ++j) {
+			X b = 0;
+			for (size_t i = 0; i <= j; ++i) {
+				b += X(binomial(j, i)) * B[j - i] * x[i];
+			}
+			B[j + 1] = b;
 		}
 
-		return B[n - 1];
+		return B[n];
 	}
 
-	// Bell polynomials
-	// B_n(x_1, ..., x_n)
+	// Moments m_0, ..., m_n from cumulants kappa_1, ..., kappa_n where kappa[0] = kappa_1.
+	template<class X = double>
+	inline constexpr void moment_from_cumulant(size_t n, const X* kappa, X* m)
+	{
+		m[0] = X(1);
+		for (size_t j = 0; j < n; ++j) {
+			X b = 0;
+			for (size_t i = 0; i <= j; ++i) {
+				b += X(binomial(j, i)) * m[j - i] * kappa[i];
+			}
+			m[j + 1] = b;
+		}
+	}
 
+	// Cumulants kappa_1, ..., kappa_n from moments m_0 = 1, m_1, ..., m_n.
+	// If m_j = M^{(j)}(s)/M(s) then kappa_j = (d/ds)^j log M(s).
+	template<class X = double>
+	inline constexpr void cumulant_from_moment(size_t n, const X* m, X* kappa)
+	{
+		for (size_t j = 0; j < n; ++j) {
+			X b = m[j + 1];
+			for (size_t i = 0; i < j; ++i) {
+				b -= X(binomial(j, i)) * kappa[i] * m[j - i];
+			}
+			kappa[j] = b;
+		}
+	}
 
+	// n-th moment of the Esscher transform X_s from the cumulant derivatives of a variate.
+	template<class M, class S = typename M::stype>
+	inline S moment(const M& m, size_t n, S s = 0)
+	{
+		if (n >= BELL_MAX) {
+			return std::numeric_limits<S>::quiet_NaN();
+		}
+
+		S kappa[BELL_MAX];
+		for (size_t j = 0; j < n; ++j) {
+			kappa[j] = m.cumulant(s, j + 1);
+		}
+
+		return Bell(n, kappa);
+	}
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,87 @@
+// fms_bell.t.cpp - test Bell polynomials
+#include <cassert>
+#include <cmath>
+#include "fms_bell.h"
+#include "fms_variate_discrete.h"
+
+using namespace fms;
+
+static_assert(choose(5, 2) == 10);
+static_assert(choose(2, 5) == 0);
+static_assert(binomial(5, 2) == 10);
+static_assert(binomial(30, 15) == choose(30, 15));
+
+// Bell numbers are complete Bell polynomials at x = 1
+constexpr double one[] = { 1, 1, 1, 1, 1, 1 };
+static_assert(Bell(0, one) == 1);
+static_assert(Bell(5, one) == 52);
+static_assert(Bell(6, one) == 203);
+
+// standard normal moments from cumulants 0, 1, 0, ...
+constexpr double normal_kappa[] = { 0, 1, 0, 0, 0, 0 };
+static_assert(Bell(4, normal_kappa) == 3);
+static_assert(Bell(6, normal_kappa) == 15);
+
+// Stirling numbers of the second kind
+constexpr double stirling(size_t n, size_t k)
+{
+	double B[36];
+	Bell(5, one, B);
+
+	return B[n * 6 + k];
+}
+static_assert(stirling(5, 2) == 15);
+static_assert(stirling(5, 3) == 25);
+static_assert(stirling(4, 0) == 0);
+
+template<class X = double>
+int test_bell()
+{
+	X eps = std::numeric_limits<X>::epsilon();
+
+	{
+		X kappa[] = { X(0.1), X(1.2), X(-0.3), X(0.4), X(0.05), X(-0.2) };
+		X m[7], kappa_[6];
+
+		moment_from_cumulant(6, kappa, m);
+		assert(m[0] == 1);
+		assert(m[1] == kappa[0]);
+		assert(fabs(m[2] - (kappa[1] + kappa[0] * kappa[0])) <= eps);
+
+		cumulant_from_moment(6, m, kappa_);
+		for (size_t i = 0; i < 6; ++i) {
+			assert(fabs(kappa[i] - kappa_[i]) <= 100 * m[6] * eps);
+		}
+	}
+	{
+		// Rademacher: kappa_4 = m_4 - 3 m_2^2 = -2
+		variate::discrete<X, X> d({ -1, 1 }, { 0.5, 0.5 });
+
+		assert(d.cumulant(0, 3) == 0);
+		assert(fabs(d.cumulant(0, 4) + 2) <= eps);
+		assert(fabs(moment(d, 4) - 1) <= 10 * eps);
+		assert(fabs(moment(d, 3)) <= eps);
+
+		// d/ds kappa^(3)(s) = kappa^(4)(s)
+		X s = X(0.3), h = X(1e-4);
+		X dk = (d.cumulant(s + h, 3) - d.cumulant(s - h, 3)) / (2 * h);
+		assert(fabs(dk - d.cumulant(s, 4)) <= 1e-6);
+	}
+	{
+		// moments of the Esscher transform are tilted moments
+		X x[] = { -1, 0, 2 };
+		X p[] = { X(0.5), X(0.25), X(0.25) };
+		variate::discrete<X, X> d(3, x, p);
+		X s = X(0.2);
+
+		X e0 = 0, e5 = 0;
+		for (size_t i = 0; i < 3; ++i) {
+			e0 += ::exp(s * x[i]) * p[i];
+			e5 += ::exp(s * x[i]) * ::pow(x[i], X(5)) * p[i];
+		}
+		assert(fabs(moment(d, 5, s) - e5 / e0) <= 100 * eps);
+	}
+
+	return 0;
+}
+int test_bell_d = test_bell<double>();
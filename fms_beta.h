@@ -0,0 +1,37 @@
+// fms_beta.h - incomplete beta function for Esscher transformed logistic variates
+// B_w(1 + t, 1 - t) = int_0^w u^t (1 - u)^{-t} du = w^{1+t} sum_n (t)_n/n! w^n/(1 + t + n)
+// where (t)_n is the rising factorial. The series and its term by term derivative in t
+// converge geometrically for w <= 1/2. Use B_u = B(1 + t, 1 - t) - B_{1-u}(1 - t, 1 + t) above.
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace fms {
+
+	// b = B_w(1 + t, 1 - t) and db = (d/dt) B_w(1 + t, 1 - t) for 0 < w <= 1/2 and |t| < 1
+	template<class X, class S>
+	inline void beta_inc(X w, S t, X& b, X& db)
+	{
+		X lw = ::log(w);
+		X wn = ::exp((1 + X(t)) * lw);
+		X p = 1, dp = 0; // (t)_n/n! and derivative
+
+		b = db = 0;
+		for (size_t n = 0; n < 256 and wn != 0; ++n) {
+			X c = 1 / (1 + X(t) + n);
+			X bn = wn * p * c;
+			X dbn = wn * (p * c * lw + dp * c - p * c * c);
+			b += bn;
+			db += dbn;
+			if (n > 0 and ::fabs(bn) + ::fabs(dbn) <= std::numeric_limits<X>::epsilon() * (::fabs(b) + ::fabs(db))) {
+				break;
+			}
+
+			dp = (dp * (X(t) + n) + p) / (n + 1);
+			p = p * (X(t) + n) / (n + 1);
+			wn *= w;
+		}
+	}
+
+}
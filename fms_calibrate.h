@@ -0,0 +1,130 @@
+// fms_calibrate.h - fit forward and vol of many option chains in parallel
+// Each (underlying, expiry) slice is a small Levenberg-Marquardt problem in
+// log f and log s with Jacobian f delta and s vega from fms::option.
+// Variate location and scale parameters, e.g. normal_impl mu and sigma, cancel or
+// are confounded with s since F = f exp(s X - kappa(s)), so s is what gets fit.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_levenberg_marquardt.h"
+#include "fms_option.h"
+
+namespace fms::calibrate {
+
+	// One option chain. f and s are the initial guess and hold the fit on return.
+	template<class X = double>
+	struct slice {
+		X f;              // forward
+		X s;              // vol
+		size_t m;         // number of quotes
+		const X* k;       // strike, negative for put
+		const X* v;       // value
+		const X* w;       // optional residual weights
+		X cost;           // |w (value - v)|^2/2 at the fit
+		size_t iter;      // Levenberg-Marquardt iterations
+	};
+
+	// Fit s, and f if forward is true, for one slice using workspace lm.
+	template<class M, class X>
+	inline size_t fit(const option<M>& o, slice<X>& sl, levenberg_marquardt<X>& lm, bool forward = false,
+		size_t iter = 100, X eps = 0)
+	{
+		ensure(sl.f > 0);
+		ensure(sl.s > 0);
+
+		size_t n = forward ? 2 : 1;
+		lm.resize(sl.m, n);
+
+		X p[2] = { ::log(sl.s), ::log(sl.f) };
+
+		auto r = [&](const X* p_, X* r_, X* J) {
+			X s = ::exp(p_[0]);
+			X f = forward ? ::exp(p_[1]) : sl.f;
+
+			for (size_t j = 0; j < sl.m; ++j) {
+				X w = sl.w ? sl.w[j] : X(1);
+				X k = sl.k[j];
+
+				r_[j] = w * (o.value(f, s, k) - sl.v[j]);
+				if (J) {
+					J[j * n] = w * s * o.vega(f, s, k);
+					if (forward) {
+						J[j * n + 1] = w * f * o.delta(f, s, k);
+					}
+				}
+			}
+		};
+
+		sl.iter = lm.solve(r, p, iter, eps);
+		sl.cost = lm.cost();
+		sl.s = ::exp(p[0]);
+		if (forward) {
+			sl.f = ::exp(p[1]);
+		}
+
+		return sl.iter;
+	}
+
+	// Fit n slices using up to t threads, each with its own workspace.
+	// Returns the total number of iterations.
+	template<class M, class X>
+	inline size_t fit(const M& m, size_t n, slice<X>* sl, bool forward = false, unsigned t = 0)
+	{
+		if (t == 0) {
+			t = (std::max)(1u, std::thread::hardware_concurrency());
+		}
+		t = static_cast<unsigned>((std::min)(size_t(t), n));
+
+		size_t mmax = 0;
+		for (size_t i = 0; i < n; ++i) {
+			mmax = (std::max)(mmax, sl[i].m);
+		}
+
+		// threads grab small blocks of slices to balance uneven chains
+		static constexpr size_t block = 16;
+		std::atomic<size_t> next = 0;
+		std::atomic<size_t> iter = 0;
+		std::exception_ptr e;
+		std::mutex em;
+		auto work = [&]() {
+			option o(m);
+			levenberg_marquardt<X> lm(mmax, forward ? 2 : 1);
+			size_t it = 0;
+
+			try {
+				for (size_t i = next.fetch_add(block); i < n; i = next.fetch_add(block)) {
+					for (size_t j = i; j < (std::min)(i + block, n); ++j) {
+						it += fit(o, sl[j], lm, forward);
+					}
+				}
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(em);
+				e = std::current_exception();
+				next = n;
+			}
+			iter += it;
+		};
+
+		std::vector<std::thread> ts;
+		for (unsigned i = 1; i < t; ++i) {
+			ts.emplace_back(work);
+		}
+		work();
+		for (auto& t_ : ts) {
+			t_.join();
+		}
+		if (e) {
+			std::rethrow_exception(e);
+		}
+
+		return iter;
+	}
+
+}
@@ -0,0 +1,55 @@
+// fms_calibrate.t.cpp - test parallel slice calibration
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "fms_calibrate.h"
+#include "fms_variate_normal.h"
+
+using namespace fms;
+
+template<class X = double>
+int test_calibrate()
+{
+	variate::normal_impl<X> N;
+	option o(N);
+
+	constexpr size_t n = 1000; // slices
+	constexpr size_t m = 21;   // quotes per slice
+	std::vector<X> k(n * m), v(n * m), f(n), s(n);
+	std::vector<calibrate::slice<X>> sl(n);
+
+	for (size_t i = 0; i < n; ++i) {
+		f[i] = 100 + X(i % 50);
+		s[i] = X(0.05) + X(i % 37) / 100;
+		for (size_t j = 0; j < m; ++j) {
+			X k_ = f[i] * (X(0.8) + X(j) / 50);
+			k[i * m + j] = k_ < f[i] ? -k_ : k_;
+			v[i * m + j] = o.value(f[i], s[i], k[i * m + j]);
+		}
+		sl[i] = calibrate::slice<X>{ f[i], X(0.2), m, &k[i * m], &v[i * m], nullptr, 0, 0 };
+	}
+
+	{
+		calibrate::fit(N, n, sl.data());
+		for (size_t i = 0; i < n; ++i) {
+			assert(sl[i].f == f[i]);
+			assert(fabs(sl[i].s - s[i]) < 1e-8);
+			assert(sl[i].cost < 1e-12);
+		}
+	}
+	{
+		// forward off by 1%
+		for (size_t i = 0; i < n; ++i) {
+			sl[i].f = f[i] * X(1.01);
+			sl[i].s = X(0.2);
+		}
+		calibrate::fit(N, n, sl.data(), true, 4);
+		for (size_t i = 0; i < n; ++i) {
+			assert(fabs(sl[i].f - f[i]) < 1e-6);
+			assert(fabs(sl[i].s - s[i]) < 1e-8);
+		}
+	}
+
+	return 0;
+}
+int test_calibrate_d = test_calibrate<double>();
@@ -0,0 +1,179 @@
+// fms_calibrate_discrete.h - fit discrete variate atoms and probabilities to option prices
+// Probabilities are p = softmax(theta) and atoms are x = (y - E[y])/Var(y)^{1/2}
+// so every iterate is a valid mean 0 variance 1 discrete variate.
+// With F_i = f exp(s x_i - kappa(s)) = f exp(t y_i)/sum_j p_j exp(t y_j), t = s/Var(y)^{1/2},
+// a call is worth sum_i p_i (F_i - k)^+ and the Jacobian is analytic.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_levenberg_marquardt.h"
+#include "fms_variate_discrete.h"
+
+namespace fms::calibrate {
+
+	// The last fit is the warm start for the next.
+	template<class X = double, class S = X>
+	class discrete {
+		size_t n;
+		std::vector<X> q; // theta_0, ..., theta_{n-1}, y_0, ..., y_{n-1}
+		std::vector<X> p, u, a, F; // probability, centered y, exp(t u), forward at atom
+		X sigma, t, Z;
+		levenberg_marquardt<X> lm;
+
+		// fill per atom workspace for parameters q_
+		void state(const X* q_, X f, S s)
+		{
+			const X* theta = q_;
+			const X* y = q_ + n;
+
+			X tmax = *std::max_element(theta, theta + n);
+			X P = 0;
+			for (size_t i = 0; i < n; ++i) {
+				p[i] = ::exp(theta[i] - tmax);
+				P += p[i];
+			}
+			X m = 0;
+			for (size_t i = 0; i < n; ++i) {
+				p[i] /= P;
+				m += p[i] * y[i];
+			}
+			X v = 0;
+			for (size_t i = 0; i < n; ++i) {
+				u[i] = y[i] - m;
+				v += p[i] * u[i] * u[i];
+			}
+			sigma = ::sqrt(v);
+			t = X(s) / sigma;
+
+			X umax = *std::max_element(u.begin(), u.end());
+			Z = 0;
+			for (size_t i = 0; i < n; ++i) {
+				a[i] = ::exp(t * (u[i] - umax));
+				Z += p[i] * a[i];
+			}
+			for (size_t i = 0; i < n; ++i) {
+				F[i] = f * a[i] / Z;
+			}
+		}
+	public:
+		typedef X xtype;
+		typedef S stype;
+
+		// n atoms on [-3, 3] with normal weights
+		discrete(size_t n = 16)
+			: n(n), q(2 * n), p(n), u(n), a(n), F(n), sigma(1), t(0), Z(1)
+		{
+			ensure(n > 1);
+
+			for (size_t i = 0; i < n; ++i) {
+				X y = -3 + X(6 * i) / X(n - 1);
+				q[i] = -y * y / 2;
+				q[n + i] = y;
+			}
+		}
+		// warm start from a model
+		template<class D>
+			requires requires (const D& d) { d.atom(0); d.probability(0); }
+		discrete(const D& d)
+			: discrete(d.size())
+		{
+			static constexpr X tiny = std::numeric_limits<X>::min();
+
+			for (size_t i = 0; i < n; ++i) {
+				q[i] = ::log((std::max)(X(d.probability(i)), tiny));
+				q[n + i] = d.atom(i);
+			}
+		}
+		discrete(const discrete&) = default;
+		discrete& operator=(const discrete&) = default;
+		~discrete()
+		{ }
+
+		size_t size() const noexcept
+		{
+			return n;
+		}
+
+		// weighted sum of squared price errors at the last fit
+		X cost() const noexcept
+		{
+			return lm.cost();
+		}
+
+		// Fit m quotes with strike k (negative for put) and value v at forward f and vol s.
+		// Optional w scales each residual. Returns the number of iterations.
+		size_t fit(X f, S s, size_t m, const X* k, const X* v, const X* w = nullptr, size_t iter = 100, X eps = 0)
+		{
+			ensure(f > 0);
+			ensure(s > 0);
+
+			lm.resize(m, 2 * n);
+
+			auto r = [&](const X* q_, X* r_, X* J) {
+				state(q_, f, s);
+
+				// ybar = E_t[u] under the tilted probabilities
+				X ybar = 0;
+				for (size_t i = 0; i < n; ++i) {
+					ybar += p[i] * a[i] * u[i];
+				}
+				ybar /= Z;
+
+				for (size_t j = 0; j < m; ++j) {
+					X kj = ::fabs(k[j]);
+					X wj = w ? w[j] : X(1);
+
+					X V = 0, G = 0, H = 0;
+					for (size_t i = 0; i < n; ++i) {
+						X c = X(F[i] > kj);
+						V += c * p[i] * (F[i] - kj);
+						G += c * p[i] * F[i];
+						H += c * p[i] * F[i] * (u[i] - ybar);
+					}
+					if (k[j] < 0) { // put-call parity
+						V -= f - kj;
+					}
+					r_[j] = wj * (V - v[j]);
+
+					if (J) {
+						X* Jt = J + j * 2 * n; // d/dtheta
+						X* Jy = Jt + n;        // d/dy
+						X dt = -t / (2 * sigma * sigma); // dt/dVar(y)
+
+						X gbar = 0;
+						for (size_t i = 0; i < n; ++i) {
+							X c = X(F[i] > kj);
+							X gp = c * (F[i] - kj) - (a[i] / Z) * G + H * dt * u[i] * u[i];
+							Jt[i] = gp;
+							gbar += p[i] * gp;
+							Jy[i] = wj * (t * p[i] * (c * F[i] - (a[i] / Z) * G) + H * dt * 2 * p[i] * u[i]);
+						}
+						for (size_t i = 0; i < n; ++i) {
+							Jt[i] = wj * p[i] * (Jt[i] - gbar);
+						}
+					}
+				}
+			};
+
+			return lm.solve(r, q.data(), iter, eps);
+		}
+
+		// mean 0 variance 1 model at the last fit
+		variate::discrete<X, S> model()
+		{
+			state(q.data(), X(1), S(1));
+
+			std::vector<X> x(n);
+			for (size_t i = 0; i < n; ++i) {
+				x[i] = u[i] / sigma;
+			}
+			variate::discrete_normalize(n, p.data());
+
+			return variate::discrete<X, S>(n, x.data(), p.data());
+		}
+	};
+
+}
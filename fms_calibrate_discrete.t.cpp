@@ -0,0 +1,68 @@
+// fms_calibrate_discrete.t.cpp - test discrete variate calibration
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "fms_calibrate_discrete.h"
+#include "fms_option.h"
+
+using namespace fms;
+
+template<class X = double>
+int test_calibrate_discrete()
+{
+	X f = 100;
+	X s = X(0.2);
+
+	// skewed mean 0 variance 1 target
+	X y[] = { -3, -1.5, -0.5, 0, 0.5, 1, 2 };
+	X p[] = { 0.02, 0.1, 0.2, 0.3, 0.2, 0.13, 0.05 };
+	constexpr size_t n = sizeof(y) / sizeof(*y);
+	X m = 0, v = 0;
+	for (size_t i = 0; i < n; ++i) {
+		m += p[i] * y[i];
+	}
+	for (size_t i = 0; i < n; ++i) {
+		v += p[i] * (y[i] - m) * (y[i] - m);
+	}
+	for (size_t i = 0; i < n; ++i) {
+		y[i] = (y[i] - m) / ::sqrt(v);
+	}
+	variate::discrete<X, X> d(n, y, p);
+	option o(d);
+
+	// puts below the forward, calls above
+	std::vector<X> k, c;
+	for (X k_ = 50; k_ <= 150; k_ += 1) {
+		k.push_back(k_ < f ? -k_ : k_);
+		c.push_back(o.value(f, s, k.back()));
+	}
+
+	{
+		calibrate::discrete<X, X> cd(n);
+		cd.fit(f, s, k.size(), k.data(), c.data(), nullptr, 200);
+		assert(cd.cost() < 1e-8);
+
+		auto d_ = cd.model();
+		assert(fabs(d_.cumulant(0, 1)) < 1e-12);
+		assert(fabs(d_.cumulant(0, 2) - 1) < 1e-12);
+
+		option o_(d_);
+		for (size_t j = 0; j < k.size(); ++j) {
+			assert(fabs(o_.value(f, s, k[j]) - c[j]) < 1e-4);
+		}
+
+		// warm start from the previous fit
+		size_t it = cd.fit(f, s, k.size(), k.data(), c.data());
+		assert(it <= 2);
+	}
+	{
+		// warm start from a model
+		calibrate::discrete<X, X> cd(d);
+		size_t it = cd.fit(f, s, k.size(), k.data(), c.data());
+		assert(it <= 2);
+		assert(cd.cost() < 1e-8);
+	}
+
+	return 0;
+}
+int test_calibrate_discrete_d = test_calibrate_discrete<double>();
@@ -0,0 +1,94 @@
+// fms_density.h - risk neutral density of the forward on a strike grid
+// Breeden-Litzenberger: F has density c_kk(k) and cdf P(F <= k) = 1 + c_k(k).
+// Option values are homogeneous of degree 1 in f and k so c_kk = (f/k)^2 c_ff
+// is a scaled gamma and 1 + c_k is the digital put value. Market chains use
+// finite differences of call values on the strike grid instead.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_option.h"
+#include "fms_variate_discrete.h"
+
+namespace fms {
+
+	// Density q and cdf P of the forward at n strikes k from a model.
+	template<class M, class X>
+	inline void density(const option<M>& o, X f, X s, size_t n, const X* k, X* q, X* P = nullptr)
+	{
+		o.gamma(f, s, n, k, q);
+		for (size_t i = 0; i < n; ++i) {
+			q[i] *= (f / k[i]) * (f / k[i]);
+		}
+		if (P) {
+			o.digital_put(f, s, n, k, P);
+		}
+	}
+
+	// Density q and cdf P of the forward at n > 2 strikes from quotes sorted by strike, negative for put.
+	// Second differences are exact for piecewise linear call values. The density is 0 at the end points.
+	template<class X>
+	inline void density(X f, size_t n, const X* k, const X* v, X* q, X* P = nullptr)
+	{
+		ensure(n > 2);
+
+		std::vector<X> k_(n), c(n);
+		for (size_t i = 0; i < n; ++i) {
+			k_[i] = ::fabs(k[i]);
+			c[i] = v[i] + X(k[i] < 0) * (f - k_[i]);
+		}
+		ensure(std::is_sorted(k_.begin(), k_.end()));
+
+		q[0] = q[n - 1] = 0;
+		for (size_t i = 1; i + 1 < n; ++i) {
+			X d0 = (c[i] - c[i - 1]) / (k_[i] - k_[i - 1]);
+			X d1 = (c[i + 1] - c[i]) / (k_[i + 1] - k_[i]);
+			q[i] = 2 * (d1 - d0) / (k_[i + 1] - k_[i - 1]);
+		}
+
+		if (P) {
+			P[0] = 1 + (c[1] - c[0]) / (k_[1] - k_[0]);
+			for (size_t i = 1; i + 1 < n; ++i) {
+				// weighted so it is exact for quadratic call values
+				X h0 = k_[i] - k_[i - 1];
+				X h1 = k_[i + 1] - k_[i];
+				P[i] = 1 + ((c[i + 1] - c[i]) * h0 / h1 + (c[i] - c[i - 1]) * h1 / h0) / (h0 + h1);
+			}
+			P[n - 1] = 1 + (c[n - 1] - c[n - 2]) / (k_[n - 1] - k_[n - 2]);
+		}
+	}
+
+	// Discrete variate with atoms at log strikes and probabilities proportional to
+	// q_i (k_{i+1} - k_{i-1})/2, standardized to mean 0 and variance 1.
+	template<class X, class S = X>
+	inline variate::discrete<X, S> density_discrete(size_t n, const X* k, const X* q)
+	{
+		ensure(n > 1);
+
+		std::vector<X> x(n), p(n);
+		for (size_t i = 0; i < n; ++i) {
+			ensure(k[i] > 0);
+			x[i] = ::log(k[i]);
+			p[i] = q[i] * (k[i + (i + 1 < n)] - k[i - (i > 0)]) / 2;
+		}
+		variate::discrete_normalize(n, p.data());
+
+		X mu = 0, var = 0;
+		for (size_t i = 0; i < n; ++i) {
+			mu += p[i] * x[i];
+		}
+		for (size_t i = 0; i < n; ++i) {
+			var += p[i] * (x[i] - mu) * (x[i] - mu);
+		}
+		ensure(var > 0);
+
+		X sd = ::sqrt(var);
+		for (size_t i = 0; i < n; ++i) {
+			x[i] = (x[i] - mu) / sd;
+		}
+
+		return variate::discrete<X, S>(n, x.data(), p.data());
+	}
+
+}
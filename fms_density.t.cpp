@@ -0,0 +1,68 @@
+// fms_density.t.cpp - test risk neutral density extraction
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "fms_variate_normal.h"
+#include "fms_density.h"
+
+using namespace fms;
+
+template<class X = double>
+int test_density()
+{
+	constexpr size_t n = 401;
+	variate::normal_impl<X> N;
+	option o(N);
+	X f = 100;
+	X s = X(0.2);
+
+	// log strikes 6 standard deviations either side
+	std::vector<X> k(n), q(n), P(n);
+	for (size_t i = 0; i < n; ++i) {
+		k[i] = f * ::exp(s * (X(-6) + X(12) * i / (n - 1)) - s * s / 2);
+	}
+	{
+		density(o, f, s, n, k.data(), q.data(), P.data());
+
+		X Q = 0;
+		for (size_t i = 1; i < n; ++i) {
+			Q += (q[i] + q[i - 1]) * (k[i] - k[i - 1]) / 2;
+			assert(P[i] > P[i - 1]);
+		}
+		assert(fabs(Q - 1) < 1e-3);
+		assert(fabs(P[n / 2] - X(0.5)) < 1e-12);
+
+		// lognormal density
+		X x = ::log(k[100] / f) / s + s / 2;
+		X q_ = ::exp(-x * x / 2) / ::sqrt(2 * X(std::acos(-1.))) / (s * k[100]);
+		assert(fabs(q[100] - q_) < 1e-12);
+	}
+	{
+		auto d = density_discrete(n, k.data(), q.data());
+		assert(fabs(d.cumulant(0, 1)) < 1e-12);
+		assert(fabs(d.cumulant(0, 2) - 1) < 1e-12);
+		assert(fabs(d.cdf(X(0)) - X(0.5)) < 0.02);
+		assert(fabs(d.cdf(X(1)) - N.cdf(X(1))) < 0.02);
+
+		// usable as a pricing model
+		option od(d);
+		X c = od.value(f, s, f);
+		assert(fabs(c - o.value(f, s, f)) < 0.1);
+	}
+	{
+		// market chain, puts below the forward
+		std::vector<X> k_(n), v(n), q_(n), P_(n);
+		for (size_t i = 0; i < n; ++i) {
+			k_[i] = k[i] < f ? -k[i] : k[i];
+			v[i] = o.value(f, s, k_[i]);
+		}
+		density(f, n, k_.data(), v.data(), q_.data(), P_.data());
+		for (size_t i = 1; i + 1 < n; ++i) {
+			assert(fabs(q_[i] - q[i]) < 1e-4);
+			assert(fabs(P_[i] - P[i]) < 1e-4);
+		}
+	}
+
+	return 0;
+}
+int test_density_d = test_density<double>();
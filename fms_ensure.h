@@ -22,12 +22,21 @@
 #define ENSURE_LINE "\nline: " ENSURE_STRZ_(__LINE__)
 #define ENSURE_SPOT ENSURE_FILE ENSURE_LINE ENSURE_FUNC
 
+// count failures when instrumented
+#ifdef FMS_INSTRUMENT
+#include "fms_instrument.h"
+#define ENSURE_HOOK fms::instrument::count(fms::instrument::ensure_fail);
+#else
+#define ENSURE_HOOK
+#endif
+
 /*
 #ifdef _DEBUG
 #define ensure(e) if (!(e)) { DebugBreak(); }
 #else
 */
 #define ensure(e) if (!(e)) { \
+		ENSURE_HOOK \
 		throw std::runtime_error(ENSURE_SPOT "\nensure: \"" #e "\" failed"); \
 		} else (void)0;
 //#endif // _DEBUG
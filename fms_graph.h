@@ -0,0 +1,233 @@
+// fms_graph.h - lazy valuation graph
+// Inputs such as forwards, vols and model parameters are nodes with values that are set.
+// Computed nodes, e.g. positions valued with fms::option, are functions of earlier nodes
+// so the graph is acyclic by construction. Setting an input marks only the nodes that
+// depend on it dirty. Dirty nodes are recomputed when read, or all at once by refresh
+// one level at a time with the nodes of each level shared among threads.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "fms_ensure.h"
+
+namespace fms {
+
+	template<class X = double>
+	class graph {
+	public:
+		typedef size_t node;
+		typedef std::function<X(const X*)> function; // of argument values
+	private:
+		struct item {
+			function f; // empty for inputs
+			std::vector<node> in; // arguments
+			std::vector<node> out; // dependents
+			std::vector<X> a; // argument values
+			size_t level; // 0 for inputs, otherwise 1 + largest argument level
+			X value;
+			bool dirty;
+		};
+		std::vector<item> g;
+		std::vector<node> stack; // scratch for set
+		size_t evaluations_;
+
+		void evaluate(item& i)
+		{
+			for (size_t j = 0; j < i.in.size(); ++j) {
+				i.a[j] = g[i.in[j]].value;
+			}
+			i.value = i.f(i.a.data());
+			i.dirty = false;
+		}
+	public:
+		graph()
+			: evaluations_(0)
+		{ }
+		graph(const graph&) = default;
+		graph& operator=(const graph&) = default;
+		~graph()
+		{ }
+
+		size_t size() const noexcept
+		{
+			return g.size();
+		}
+		size_t level(node i) const
+		{
+			return g[i].level;
+		}
+		bool dirty(node i) const
+		{
+			return g[i].dirty;
+		}
+		// number of nodes computed so far
+		size_t evaluations() const noexcept
+		{
+			return evaluations_;
+		}
+
+		node input(X x)
+		{
+			g.push_back(item{ function{}, {}, {}, {}, 0, x, false });
+
+			return g.size() - 1;
+		}
+		// Node f(a) where a are the values of the n nodes in.
+		node add(function f, size_t n, const node* in)
+		{
+			ensure(f);
+
+			node i = g.size();
+			size_t l = 0;
+			for (size_t j = 0; j < n; ++j) {
+				ensure(in[j] < i);
+				l = (std::max)(l, g[in[j]].level + 1);
+			}
+			g.push_back(item{ std::move(f), std::vector<node>(in, in + n), {}, std::vector<X>(n), l, X(0), true });
+			for (size_t j = 0; j < n; ++j) {
+				auto& out = g[in[j]].out;
+				if (out.empty() or out.back() != i) {
+					out.push_back(i);
+				}
+			}
+
+			return i;
+		}
+		node add(function f, std::initializer_list<node> in)
+		{
+			return add(std::move(f), in.size(), in.begin());
+		}
+
+		// Set an input and mark its dependents dirty.
+		void set(node i, X x)
+		{
+			ensure(i < g.size() and !g[i].f);
+			if (g[i].value == x) {
+				return;
+			}
+
+			g[i].value = x;
+			stack.assign(g[i].out.begin(), g[i].out.end());
+			while (!stack.empty()) {
+				node j = stack.back();
+				stack.pop_back();
+				// dependents of dirty nodes are already dirty
+				if (!g[j].dirty) {
+					g[j].dirty = true;
+					stack.insert(stack.end(), g[j].out.begin(), g[j].out.end());
+				}
+			}
+		}
+
+		// Value of node i, recomputing dirty arguments first.
+		X get(node i)
+		{
+			ensure(i < g.size());
+
+			item& gi = g[i];
+			if (gi.dirty) {
+				for (node j : gi.in) {
+					if (g[j].dirty) {
+						get(j);
+					}
+				}
+				evaluate(gi);
+				++evaluations_;
+			}
+
+			return gi.value;
+		}
+
+		// Recompute every dirty node using threads threads, or one per core if 0.
+		void refresh(unsigned threads = 0)
+		{
+			// dirty nodes by level
+			std::vector<size_t> lo;
+			std::vector<node> order;
+			for (node i = 0; i < g.size(); ++i) {
+				if (g[i].dirty) {
+					if (lo.size() <= g[i].level + 1) {
+						lo.resize(g[i].level + 2, 0);
+					}
+					++lo[g[i].level + 1];
+				}
+			}
+			if (lo.empty()) {
+				return;
+			}
+			for (size_t l = 1; l < lo.size(); ++l) {
+				lo[l] += lo[l - 1];
+			}
+			order.resize(lo.back());
+			{
+				std::vector<size_t> at(lo.begin(), lo.end() - 1);
+				for (node i = 0; i < g.size(); ++i) {
+					if (g[i].dirty) {
+						order[at[g[i].level]++] = i;
+					}
+				}
+			}
+			size_t levels = lo.size() - 1;
+
+			if (threads == 0) {
+				threads = (std::max)(1u, std::thread::hardware_concurrency());
+			}
+			size_t widest = 0;
+			for (size_t l = 0; l < levels; ++l) {
+				widest = (std::max)(widest, lo[l + 1] - lo[l]);
+			}
+			threads = static_cast<unsigned>((std::min)(size_t(threads), widest));
+
+			// the last thread to finish a level starts the next
+			size_t l = 0;
+			std::atomic<size_t> next = lo[0];
+			std::barrier sync(threads, [&]() noexcept {
+				++l;
+				next = l < levels ? lo[l] : 0;
+			});
+			std::exception_ptr e;
+			std::mutex em;
+			std::atomic<bool> failed = false;
+			auto work = [&]() {
+				for (size_t l_ = 0; l_ < levels; ++l_) {
+					size_t end = lo[l_ + 1];
+					for (size_t j = next++; j < end and !failed; j = next++) {
+						try {
+							evaluate(g[order[j]]);
+						}
+						catch (...) {
+							std::lock_guard<std::mutex> lock(em);
+							if (!e) {
+								e = std::current_exception();
+							}
+							failed = true;
+						}
+					}
+					sync.arrive_and_wait();
+				}
+			};
+
+			std::vector<std::thread> ts;
+			for (unsigned i = 1; i < threads; ++i) {
+				ts.emplace_back(work);
+			}
+			work();
+			for (auto& t : ts) {
+				t.join();
+			}
+			for (node i : order) {
+				evaluations_ += !g[i].dirty;
+			}
+			if (e) {
+				std::rethrow_exception(e);
+			}
+		}
+	};
+
+}
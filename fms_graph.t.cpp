@@ -0,0 +1,88 @@
+// fms_graph.t.cpp - test lazy valuation graph
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "fms_graph.h"
+#include "fms_option.h"
+#include "fms_variate_normal.h"
+
+using namespace fms;
+
+int test_graph()
+{
+	using node = graph<>::node;
+	variate::normal_impl<> N;
+	option o(N);
+
+	// forward and vol for each of m expiries, n strikes per expiry, and a book total
+	constexpr size_t m = 4, n = 8;
+	graph<> g;
+	std::vector<node> f, s, p;
+	for (size_t i = 0; i < m; ++i) {
+		f.push_back(g.input(100));
+		s.push_back(g.input(0.1 * (i + 1)));
+	}
+	for (size_t i = 0; i < m; ++i) {
+		for (size_t j = 0; j < n; ++j) {
+			double k = 80 + 5 * j;
+			p.push_back(g.add([&o, k](const double* a) { return o.value(a[0], a[1], k); }, { f[i], s[i] }));
+		}
+	}
+	node book = g.add([](const double* a) {
+		double v = 0;
+		for (size_t i = 0; i < m * n; ++i) {
+			v += a[i];
+		}
+		return v;
+	}, p.size(), p.data());
+	assert(g.level(f[0]) == 0 and g.level(p[0]) == 1 and g.level(book) == 2);
+	assert(g.dirty(book));
+
+	double v0 = g.get(book);
+	assert(g.evaluations() == m * n + 1);
+	assert(!g.dirty(p[0]));
+	assert(g.get(book) == v0);
+	assert(g.evaluations() == m * n + 1);
+
+	// one vol moves so only its expiry and the book are recomputed
+	g.set(s[2], 0.35);
+	assert(g.dirty(book) and g.dirty(p[2 * n]) and !g.dirty(p[0]));
+	double v1 = g.get(book);
+	assert(g.evaluations() == m * n + 1 + n + 1);
+	assert(v1 > v0);
+	assert(fabs(g.get(p[2 * n + 3]) - o.value(100., 0.35, 95.)) < 1e-15);
+
+	// unchanged inputs do nothing
+	g.set(s[2], 0.35);
+	assert(!g.dirty(book));
+
+	// parallel refresh matches lazy reads
+	g.set(f[0], 101);
+	g.set(f[3], 99);
+	g.refresh(4);
+	assert(!g.dirty(book));
+	assert(g.evaluations() == m * n + 1 + n + 1 + 2 * n + 1);
+	double v2 = g.get(book);
+	graph<> h(g);
+	h.set(f[0], 100);
+	h.set(f[3], 100);
+	assert(h.get(book) == v1);
+	h.set(f[0], 101);
+	h.set(f[3], 99);
+	assert(h.get(book) == v2);
+
+	// errors propagate and leave nodes dirty
+	g.set(f[1], -1);
+	try {
+		g.refresh(2);
+		assert(false);
+	}
+	catch (const std::exception&) {
+		assert(g.dirty(book));
+	}
+	g.set(f[1], 100);
+	assert(g.get(book) == v2);
+
+	return 0;
+}
+int test_graph_ = test_graph();
@@ -0,0 +1,197 @@
+// fms_instrument.h - optional hot path counters, histograms and timers
+// Define FMS_INSTRUMENT for the whole build to turn instrumentation on.
+// Otherwise every hook is an empty inline function and timer is an empty struct.
+// Counters are relaxed atomics shared by all threads. Timers use the time stamp
+// counter where available and steady_clock ticks otherwise.
+// The hooks live in inline namespace on or off so a translation unit that defines
+// FMS_INSTRUMENT, such as the unit test, links to different symbols than the rest.
+// Templates such as option<M> are still only consistent for distinct models M.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#ifdef FMS_INSTRUMENT
+#include <atomic>
+#include <chrono>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace fms::instrument {
+
+	enum counter {
+		cdf,
+		cumulant,
+		moneyness,
+		implied,      // quotes inverted
+		implied_fail, // quotes with no solution
+		ensure_fail,  // failed ensure
+		counters
+	};
+	inline constexpr const char* counter_name[counters] = {
+		"cdf", "cumulant", "moneyness", "implied", "implied_fail", "ensure_fail"
+	};
+
+	enum timer_id {
+		implied_chain, // option::implied over a chain
+		strip,         // option strip overloads
+		batch,         // price::price over records
+		timers
+	};
+	inline constexpr const char* timer_name[timers] = {
+		"implied_chain", "strip", "batch"
+	};
+
+	// implied iteration counts 1, 2, ..., the last bin counts bins or more
+	inline constexpr size_t bins = 16;
+
+	struct snapshot {
+		uint64_t calls[counters];
+		uint64_t iterations[bins];
+		uint64_t ticks[timers]; // total ticks in each timer
+		uint64_t scopes[timers]; // number of timed scopes
+		double seconds; // since reset
+
+		// {"calls":{...},"iterations":[...],"timers":{"name":{"ticks":t,"scopes":n}},"seconds":s}
+		std::string json() const
+		{
+			std::string s = "{\"calls\":{";
+			for (size_t i = 0; i < counters; ++i) {
+				s += (i ? ",\"" : "\"") + std::string(counter_name[i]) + "\":" + std::to_string(calls[i]);
+			}
+			s += "},\"iterations\":[";
+			for (size_t i = 0; i < bins; ++i) {
+				s += (i ? "," : "") + std::to_string(iterations[i]);
+			}
+			s += "],\"timers\":{";
+			for (size_t i = 0; i < timers; ++i) {
+				s += (i ? ",\"" : "\"") + std::string(timer_name[i]) + "\":{\"ticks\":" + std::to_string(ticks[i])
+					+ ",\"scopes\":" + std::to_string(scopes[i]) + "}";
+			}
+			s += "},\"seconds\":" + std::to_string(seconds) + "}";
+
+			return s;
+		}
+	};
+
+#ifdef FMS_INSTRUMENT
+
+	inline namespace on {
+
+		inline constexpr bool enabled = true;
+
+		struct state {
+			std::atomic<uint64_t> calls[counters];
+			std::atomic<uint64_t> iterations[bins];
+			std::atomic<uint64_t> ticks[timers];
+			std::atomic<uint64_t> scopes[timers];
+			std::atomic<int64_t> start; // steady_clock ticks at reset
+		};
+		inline state global{};
+
+		inline uint64_t tick() noexcept
+		{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+			return __rdtsc();
+#else
+			return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+		}
+
+		inline void count(counter c, uint64_t n = 1) noexcept
+		{
+			global.calls[c].fetch_add(n, std::memory_order_relaxed);
+		}
+		inline void iterations(size_t n) noexcept
+		{
+			size_t i = n == 0 ? 0 : (n < bins ? n - 1 : bins - 1);
+			global.iterations[i].fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// time a scope
+		class timer {
+			timer_id id;
+			uint64_t t0;
+		public:
+			timer(timer_id id) noexcept
+				: id(id), t0(tick())
+			{ }
+			timer(const timer&) = delete;
+			timer& operator=(const timer&) = delete;
+			~timer()
+			{
+				global.ticks[id].fetch_add(tick() - t0, std::memory_order_relaxed);
+				global.scopes[id].fetch_add(1, std::memory_order_relaxed);
+			}
+		};
+
+		inline void reset() noexcept
+		{
+			for (auto& c : global.calls) {
+				c.store(0, std::memory_order_relaxed);
+			}
+			for (auto& c : global.iterations) {
+				c.store(0, std::memory_order_relaxed);
+			}
+			for (size_t i = 0; i < timers; ++i) {
+				global.ticks[i].store(0, std::memory_order_relaxed);
+				global.scopes[i].store(0, std::memory_order_relaxed);
+			}
+			global.start.store(std::chrono::steady_clock::now().time_since_epoch().count());
+		}
+
+		inline snapshot read() noexcept
+		{
+			snapshot s;
+
+			for (size_t i = 0; i < counters; ++i) {
+				s.calls[i] = global.calls[i].load(std::memory_order_relaxed);
+			}
+			for (size_t i = 0; i < bins; ++i) {
+				s.iterations[i] = global.iterations[i].load(std::memory_order_relaxed);
+			}
+			for (size_t i = 0; i < timers; ++i) {
+				s.ticks[i] = global.ticks[i].load(std::memory_order_relaxed);
+				s.scopes[i] = global.scopes[i].load(std::memory_order_relaxed);
+			}
+			int64_t t0 = global.start.load();
+			int64_t t = std::chrono::steady_clock::now().time_since_epoch().count();
+			s.seconds = t0 ? std::chrono::duration<double>(std::chrono::steady_clock::duration(t - t0)).count() : 0;
+
+			return s;
+		}
+
+	} // on
+
+#else
+
+	inline namespace off {
+
+		inline constexpr bool enabled = false;
+
+		inline void count(counter, uint64_t = 1) noexcept
+		{ }
+		inline void iterations(size_t) noexcept
+		{ }
+
+		class timer {
+		public:
+			timer(timer_id) noexcept
+			{ }
+		};
+
+		inline void reset() noexcept
+		{ }
+		inline snapshot read() noexcept
+		{
+			return snapshot{};
+		}
+
+	} // off
+
+#endif // FMS_INSTRUMENT
+
+}
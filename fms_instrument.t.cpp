@@ -0,0 +1,71 @@
+// fms_instrument.t.cpp - test hot path counters
+#define FMS_INSTRUMENT
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "fms_price.h"
+#include "fms_variate_normal.h"
+
+using namespace fms;
+
+namespace {
+	// option<M> is only instantiated with instrumentation on for this model
+	struct normal_instrumented : variate::normal_impl<> {};
+}
+
+int test_instrument()
+{
+	normal_instrumented N;
+	option o(N);
+	double f = 100, s = 0.2;
+	std::vector<double> k = { -80, -90, 100, 110, 120 };
+	size_t n = k.size();
+	std::vector<double> v(n), s_(n, 0);
+
+	instrument::reset();
+	o.value(f, s, n, k.data(), v.data());
+	auto c = instrument::read();
+	assert(c.calls[instrument::cumulant] == 1);
+	assert(c.calls[instrument::moneyness] == n);
+	assert(c.calls[instrument::cdf] >= n);
+	assert(c.scopes[instrument::strip] == 1);
+
+	v.push_back(1000); // no solution
+	k.push_back(110);
+	s_.push_back(0);
+	size_t iter = o.implied(f, n + 1, k.data(), v.data(), s_.data());
+	c = instrument::read();
+	assert(c.calls[instrument::implied] == n);
+	assert(c.calls[instrument::implied_fail] == 0); // rejected before solving
+	uint64_t m = 0, total = 0;
+	for (size_t i = 0; i < instrument::bins; ++i) {
+		m += c.iterations[i];
+		total += c.iterations[i] * (i + 1);
+	}
+	assert(m == n);
+	assert(total == iter);
+	assert(c.scopes[instrument::implied_chain] == 1);
+
+	try {
+		o.value(-f, s, k[0]);
+		assert(false);
+	}
+	catch (const std::exception&) {
+		assert(instrument::read().calls[instrument::ensure_fail] == 1);
+	}
+
+	price::record r[] = { { f, s, 100, price::kind::vanilla, 0 }, { f, s, 110, price::kind::vanilla, 0 } };
+	double out[2];
+	price::price(o, price::measure::value, 2, r, out);
+	c = instrument::read();
+	assert(c.scopes[instrument::batch] == 1);
+	assert(c.ticks[instrument::batch] > 0);
+
+	auto json = c.json();
+	assert(json.front() == '{' and json.back() == '}');
+	assert(json.find("\"cdf\":") != std::string::npos);
+	assert(json.find("\"implied_chain\":{\"ticks\":") != std::string::npos);
+
+	return 0;
+}
+int test_instrument_ = test_instrument();
@@ -0,0 +1,202 @@
+// fms_lattice.h - recombining lattice for early exercise
+// Over n steps the forward moves by exp(s_1 X - kappa(s_1)) with s_1 = s/sqrt(n), where
+// X is a discrete variate with atoms that are integer multiples j_a delta of a grid size.
+// Node i at step t has level t jmin + i so F = f exp((t jmin + i) s_1 delta - t kappa(s_1))
+// and the lattice recombines with t (jmax - jmin) + 1 nodes at step t.
+// Values are rolled back one atom at a time over contiguous node arrays owned by the
+// lattice, so steps do not allocate and the inner loops vectorize. Batches store the
+// values of all payoffs at a node together and share one sweep.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_payoff.h"
+
+namespace fms {
+
+	template<class X = double, class S = X>
+	class lattice {
+		size_t n; // steps
+		S h, kappa; // s_1 delta and kappa(s_1)
+		X d; // one step discount
+		std::vector<size_t> o; // j_a - jmin
+		std::vector<X> q; // d p_a
+		int jmin;
+		size_t w; // jmax - jmin
+		std::vector<X> u; // exp(i h)
+		std::vector<X> v, v_; // node values
+
+		// signed strike, negative for put
+		template<class K>
+			requires std::is_arithmetic_v<K>
+		static X exercise(K k, X F) noexcept
+		{
+			return k < 0 ? (std::max)(-k - F, X(0)) : (std::max)(F - k, X(0));
+		}
+		template<class P>
+			requires (!std::is_arithmetic_v<P>)
+		static X exercise(const P& p, X F) noexcept
+		{
+			return p(F);
+		}
+
+		// Value m payoffs by backward induction, exercising at steps t where e(t).
+		template<class P, class E>
+		void backward(X f, size_t m, const P* p, X* value, const E& e)
+		{
+			ensure(f > 0);
+
+			size_t N = n * w + 1;
+			if (v.size() < N * m) {
+				v.resize(N * m);
+				v_.resize(N * m);
+			}
+
+			X F0 = f * X(::exp(S(n) * (jmin * h - kappa)));
+			for (size_t i = 0; i < N; ++i) {
+				X F = F0 * u[i];
+				for (size_t b = 0; b < m; ++b) {
+					v[i * m + b] = exercise(p[b], F);
+				}
+			}
+
+			for (size_t t = n; t-- > 0; ) {
+				size_t Nt = (t * w + 1) * m;
+				X* vt = v_.data();
+				const X* v1 = v.data();
+
+				std::fill(vt, vt + Nt, X(0));
+				for (size_t a = 0; a < q.size(); ++a) {
+					X qa = q[a];
+					const X* va = v1 + o[a] * m;
+					for (size_t i = 0; i < Nt; ++i) {
+						vt[i] += qa * va[i];
+					}
+				}
+				if (e(t)) {
+					F0 = f * X(::exp(S(t) * (jmin * h - kappa)));
+					for (size_t i = 0; i <= t * w; ++i) {
+						X F = F0 * u[i];
+						for (size_t b = 0; b < m; ++b) {
+							vt[i * m + b] = (std::max)(vt[i * m + b], exercise(p[b], F));
+						}
+					}
+				}
+				v.swap(v_);
+			}
+
+			std::copy(v.data(), v.data() + m, value);
+		}
+	public:
+		// n steps to expiry with total vol s and one step discount d. The atoms of the
+		// discrete variate m must be integer multiples of delta.
+		template<class M>
+		lattice(const M& m, S s, size_t n, X delta, X d = 1)
+			: n(n), h(0), kappa(0), d(d), jmin(0), w(0)
+		{
+			ensure(n > 0);
+			ensure(s > 0);
+			ensure(delta > 0);
+			ensure(0 < d and d <= 1);
+
+			S s1 = s / ::sqrt(S(n));
+			h = s1 * S(delta);
+			kappa = m.cumulant(s1);
+			ensure(std::isfinite(kappa));
+
+			std::vector<int> j(m.size());
+			for (size_t a = 0; a < j.size(); ++a) {
+				X x = m.atom(a) / delta;
+				j[a] = static_cast<int>(::round(x));
+				ensure(::fabs(x - j[a]) <= ::sqrt(std::numeric_limits<X>::epsilon()));
+			}
+			jmin = *std::min_element(j.begin(), j.end());
+			w = *std::max_element(j.begin(), j.end()) - jmin;
+
+			for (size_t a = 0; a < j.size(); ++a) {
+				if (m.probability(a) > 0) {
+					o.push_back(j[a] - jmin);
+					q.push_back(d * m.probability(a));
+				}
+			}
+
+			u.resize(n * w + 1);
+			for (size_t i = 0; i < u.size(); ++i) {
+				u[i] = X(::exp(S(i) * h));
+			}
+		}
+		lattice(const lattice&) = default;
+		lattice& operator=(const lattice&) = default;
+		~lattice() = default;
+
+		size_t steps() const noexcept
+		{
+			return n;
+		}
+		// nodes at expiry
+		size_t nodes() const noexcept
+		{
+			return n * w + 1;
+		}
+
+		// Exercise only at expiry.
+		template<class P>
+		X european(X f, const P& p)
+		{
+			X v0;
+			backward(f, 1, &p, &v0, [](size_t) { return false; });
+
+			return v0;
+		}
+		// Exercise at any step.
+		template<class P>
+		X american(X f, const P& p)
+		{
+			X v0;
+			backward(f, 1, &p, &v0, [](size_t) { return true; });
+
+			return v0;
+		}
+		// Exercise at m increasing steps t[i] <= steps() and at expiry.
+		template<class P>
+		X bermudan(X f, const P& p, size_t m, const size_t* t)
+		{
+			X v0;
+			bermudan(f, 1, &p, &v0, m, t);
+
+			return v0;
+		}
+
+		// Values v[b] of payoffs p[b], b < m, or strikes with negative for put, in one sweep.
+		template<class P>
+		void european(X f, size_t m, const P* p, X* v0)
+		{
+			backward(f, m, p, v0, [](size_t) { return false; });
+		}
+		template<class P>
+		void american(X f, size_t m, const P* p, X* v0)
+		{
+			backward(f, m, p, v0, [](size_t) { return true; });
+		}
+		template<class P>
+		void bermudan(X f, size_t m, const P* p, X* v0, size_t m_, const size_t* t)
+		{
+			ensure(std::is_sorted(t, t + m_));
+			ensure(m_ == 0 or t[m_ - 1] <= n);
+
+			// steps run backward so track the next exercise date from the end
+			size_t i = m_;
+			backward(f, m, p, v0, [&i, t](size_t t_) {
+				while (i > 0 and t[i - 1] > t_) {
+					--i;
+				}
+
+				return i > 0 and t[i - 1] == t_;
+			});
+		}
+	};
+
+}
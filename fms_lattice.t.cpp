@@ -0,0 +1,90 @@
+// fms_lattice.t.cpp - test early exercise on a recombining lattice
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "fms_option.h"
+#include "fms_lattice.h"
+#include "fms_variate_discrete.h"
+
+using namespace fms;
+
+int test_lattice()
+{
+	double f = 100, s = 0.2;
+	variate::discrete<> B({ -1, 1 }, { 0.5, 0.5 });
+	// mean 0 variance 1 on a grid of sqrt(3)
+	double r3 = ::sqrt(3.);
+	variate::discrete<> T({ -r3, 0, r3 }, { 1. / 6, 2. / 3, 1. / 6 });
+
+	{
+		// one step is the discrete model
+		lattice L(B, s, 1, 1.);
+		option o(B);
+		for (double k : { 90., 100., 110. }) {
+			assert(fabs(L.european(f, payoff::call(k)) - o.value(f, s, payoff::call(k))) < 1e-12);
+			assert(fabs(L.european(f, -k) - o.value(f, s, payoff::put(k))) < 1e-12);
+		}
+		assert(L.nodes() == 3);
+	}
+	{
+		lattice L(T, s, 200, r3);
+		assert(L.nodes() == 401);
+
+		// converges to Black
+		double c = L.european(f, payoff::call(100.));
+		double x = s / 2;
+		double b = f * (1 + ::erf(x / ::sqrt(2.))) / 2 - 100 * (1 + ::erf(-x / ::sqrt(2.))) / 2;
+		assert(fabs(c - b) < 0.01);
+
+		// no early exercise of convex payoffs without discounting
+		assert(fabs(L.american(f, payoff::call(100.)) - c) < 1e-10);
+		assert(fabs(L.american(f, payoff::straddle(100.)) - L.european(f, payoff::straddle(100.))) < 1e-10);
+	}
+	{
+		lattice L(T, s, 100, r3, 0.9995);
+		double k = 110;
+		double e = L.european(f, payoff::put(k));
+		double a = L.american(f, payoff::put(k));
+		size_t t[] = { 25, 50, 75 };
+		double m = L.bermudan(f, payoff::put(k), 3, t);
+		assert(e < m and m < a);
+		assert(a >= k - f);
+
+		// exercising at every step is american
+		std::vector<size_t> all(101);
+		for (size_t i = 0; i <= 100; ++i) {
+			all[i] = i;
+		}
+		assert(fabs(L.bermudan(f, payoff::put(k), all.size(), all.data()) - a) < 1e-12);
+		// exercising at expiry only is european
+		size_t n[] = { 100 };
+		assert(fabs(L.bermudan(f, payoff::put(k), 1, n) - e) < 1e-12);
+
+		// digitals are exercised when in the money
+		assert(L.american(f, payoff::digital_put(k)) == 1);
+		assert(L.american(f, payoff::digital_call(k)) < 1);
+
+		// batch of strikes in one sweep
+		double K[] = { -90, -100, -110, 90, 100, 110 };
+		double v[6];
+		L.american(f, 6, K, v);
+		for (size_t i = 0; i < 6; ++i) {
+			double v_ = K[i] < 0 ? L.american(f, payoff::put(-K[i])) : L.american(f, payoff::call(K[i]));
+			assert(fabs(v[i] - v_) < 1e-12);
+		}
+		assert(v[2] == a);
+		L.bermudan(f, 6, K, v, 3, t);
+		assert(fabs(v[2] - m) < 1e-12);
+	}
+	{
+		// atoms must be on the grid
+		try {
+			lattice L(T, s, 10, 1.);
+			assert(false);
+		}
+		catch (const std::exception&) { }
+	}
+
+	return 0;
+}
+int test_lattice_ = test_lattice();
@@ -0,0 +1,196 @@
+// fms_levenberg_marquardt.h - nonlinear least squares with preallocated workspace
+// Minimize |r(p)|^2/2 where r: R^n -> R^m has Jacobian J.
+// Steps solve (J'J + lambda diag(J'J)) dp = -J'r using Cholesky.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace fms {
+
+	// Solve A x = b in place for symmetric positive definite n x n A.
+	// Only the lower triangle of A is used. Returns false if A is not positive definite.
+	template<class X>
+	inline bool cholesky_solve(size_t n, X* A, X* b) noexcept
+	{
+		for (size_t j = 0; j < n; ++j) {
+			X d = A[j * n + j];
+			for (size_t k = 0; k < j; ++k) {
+				d -= A[j * n + k] * A[j * n + k];
+			}
+			if (!(d > 0)) {
+				return false;
+			}
+			d = ::sqrt(d);
+			A[j * n + j] = d;
+			for (size_t i = j + 1; i < n; ++i) {
+				X a = A[i * n + j];
+				for (size_t k = 0; k < j; ++k) {
+					a -= A[i * n + k] * A[j * n + k];
+				}
+				A[i * n + j] = a / d;
+			}
+		}
+		// L y = b
+		for (size_t i = 0; i < n; ++i) {
+			for (size_t k = 0; k < i; ++k) {
+				b[i] -= A[i * n + k] * b[k];
+			}
+			b[i] /= A[i * n + i];
+		}
+		// L' x = y
+		for (size_t i = n; i-- > 0; ) {
+			for (size_t k = i + 1; k < n; ++k) {
+				b[i] -= A[k * n + i] * b[k];
+			}
+			b[i] /= A[i * n + i];
+		}
+
+		return true;
+	}
+
+	template<class X = double>
+	class levenberg_marquardt {
+		size_t m, n; // residuals, parameters
+		std::vector<X> r, r_, J, Jt, A, C, g, dp, p_;
+		X cost_;
+
+		// four partial sums to break the add dependency chain
+		static X dot(size_t k, const X* x, const X* y) noexcept
+		{
+			X s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+			size_t i = 0;
+			for (; i + 4 <= k; i += 4) {
+				s0 += x[i] * y[i];
+				s1 += x[i + 1] * y[i + 1];
+				s2 += x[i + 2] * y[i + 2];
+				s3 += x[i + 3] * y[i + 3];
+			}
+			for (; i < k; ++i) {
+				s0 += x[i] * y[i];
+			}
+
+			return (s0 + s1) + (s2 + s3);
+		}
+		static X norm2(size_t k, const X* x) noexcept
+		{
+			return dot(k, x, x);
+		}
+	public:
+		levenberg_marquardt(size_t m = 0, size_t n = 0)
+		{
+			resize(m, n);
+		}
+
+		// allocates only if the problem grows
+		void resize(size_t m_, size_t n_)
+		{
+			m = m_;
+			n = n_;
+			r.resize(m);
+			r_.resize(m);
+			J.resize(m * n);
+			Jt.resize(m * n);
+			A.resize(n * n);
+			C.resize(n * n);
+			g.resize(n);
+			dp.resize(n);
+			p_.resize(n);
+			cost_ = 0;
+		}
+
+		// residuals at the last accepted point
+		const X* residual() const noexcept
+		{
+			return r.data();
+		}
+		// |r|^2/2 at the last accepted point
+		X cost() const noexcept
+		{
+			return cost_;
+		}
+
+		// f(const X* p, X* r, X* J) computes residuals and, if J is not null,
+		// the row major m x n Jacobian. Returns the number of iterations.
+		template<class F>
+		size_t solve(F&& f, X* p, size_t iter = 100, X eps = 0)
+		{
+			static constexpr X epsilon = std::numeric_limits<X>::epsilon();
+
+			if (eps == 0) {
+				eps = ::sqrt(epsilon);
+			}
+
+			f(p, r.data(), J.data());
+			cost_ = norm2(m, r.data()) / 2;
+
+			X lambda = X(1e-3);
+			size_t it = 0;
+			while (it < iter) {
+				++it;
+
+				// A = J'J, g = J'r using columns of J
+				for (size_t i = 0; i < n; ++i) {
+					for (size_t k = 0; k < m; ++k) {
+						Jt[i * m + k] = J[k * n + i];
+					}
+				}
+				for (size_t i = 0; i < n; ++i) {
+					const X* Ji = Jt.data() + i * m;
+					g[i] = dot(m, Ji, r.data());
+					for (size_t j = 0; j <= i; ++j) {
+						A[i * n + j] = dot(m, Ji, Jt.data() + j * m);
+					}
+				}
+				X dmax = 0;
+				for (size_t i = 0; i < n; ++i) {
+					dmax = (std::max)(dmax, A[i * n + i]);
+				}
+				if (dmax == 0 or ::sqrt(norm2(n, g.data())) <= epsilon * (1 + cost_)) {
+					break;
+				}
+
+				// increase lambda until the step reduces the cost
+				X cost = cost_;
+				while (lambda < 1 / epsilon) {
+					std::copy(A.begin(), A.end(), C.begin());
+					for (size_t i = 0; i < n; ++i) {
+						// floor keeps directions J does not see from blowing up
+						C[i * n + i] += lambda * (std::max)(A[i * n + i], epsilon * dmax);
+						dp[i] = -g[i];
+					}
+					if (cholesky_solve(n, C.data(), dp.data())) {
+						for (size_t i = 0; i < n; ++i) {
+							p_[i] = p[i] + dp[i];
+						}
+						f(p_.data(), r_.data(), nullptr);
+						cost = norm2(m, r_.data()) / 2;
+						if (cost < cost_) {
+							break;
+						}
+					}
+					lambda *= 4;
+				}
+				if (!(cost < cost_)) {
+					break; // no descent step
+				}
+
+				std::copy(p_.begin(), p_.end(), p);
+				lambda = (std::max)(lambda / 3, epsilon);
+				X dcost = cost_ - cost;
+				cost_ = cost;
+
+				if (::sqrt(norm2(n, dp.data())) <= eps * (eps + ::sqrt(norm2(n, p))) or dcost <= epsilon * cost_) {
+					std::copy(r_.begin(), r_.end(), r.begin());
+					break;
+				}
+
+				f(p, r.data(), J.data());
+			}
+
+			return it;
+		}
+	};
+
+}
@@ -0,0 +1,266 @@
+// fms_mmap.h - map a whole file into memory
+// Read only mappings of existing files, or read write mappings of files created
+// with a given size so results can be written in place without copying, or
+// anonymous memory shared with child processes, or named memory shared with any process.
+// Pages are hinted as sequential since records are streamed front to back.
+#pragma once
+#include <cstddef>
+#include <utility>
+#include "fms_ensure.h"
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fms {
+
+	class memory_map {
+		void* p;
+		size_t n;
+#ifdef _WIN32
+		HANDLE h, hm;
+#else
+		int fd;
+#endif
+		void close() noexcept
+		{
+#ifdef _WIN32
+			if (p) {
+				UnmapViewOfFile(p);
+			}
+			if (hm) {
+				CloseHandle(hm);
+			}
+			if (h != INVALID_HANDLE_VALUE) {
+				CloseHandle(h);
+			}
+			h = INVALID_HANDLE_VALUE;
+			hm = NULL;
+#else
+			if (p) {
+				::munmap(p, n);
+			}
+			if (fd != -1) {
+				::close(fd);
+			}
+			fd = -1;
+#endif
+			p = nullptr;
+			n = 0;
+		}
+	public:
+		memory_map()
+			: p(nullptr), n(0)
+#ifdef _WIN32
+			, h(INVALID_HANDLE_VALUE), hm(NULL)
+#else
+			, fd(-1)
+#endif
+		{ }
+		// Map file read only if size is 0, otherwise create it with size bytes read write.
+		memory_map(const char* file, size_t size = 0)
+			: memory_map()
+		{
+			bool rw = size > 0;
+#ifdef _WIN32
+			h = CreateFileA(file, rw ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, NULL,
+				rw ? CREATE_ALWAYS : OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			ensure(h != INVALID_HANDLE_VALUE);
+			if (!rw) {
+				LARGE_INTEGER li;
+				if (!GetFileSizeEx(h, &li)) {
+					close();
+					ensure(!"GetFileSizeEx failed");
+				}
+				size = static_cast<size_t>(li.QuadPart);
+			}
+			n = size;
+			if (n > 0) {
+				ULARGE_INTEGER li;
+				li.QuadPart = n;
+				hm = CreateFileMappingA(h, NULL, rw ? PAGE_READWRITE : PAGE_READONLY, li.HighPart, li.LowPart, NULL);
+				p = hm ? MapViewOfFile(hm, rw ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, n) : nullptr;
+				if (!p) {
+					close();
+					ensure(!"MapViewOfFile failed");
+				}
+			}
+#else
+			fd = ::open(file, rw ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+			ensure(fd != -1);
+			if (rw) {
+				if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+					close();
+					ensure(!"ftruncate failed");
+				}
+			}
+			else {
+				struct stat st;
+				if (::fstat(fd, &st) != 0) {
+					close();
+					ensure(!"fstat failed");
+				}
+				size = static_cast<size_t>(st.st_size);
+			}
+			if (size > 0) {
+				void* q = ::mmap(nullptr, size, rw ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+				if (q == MAP_FAILED) {
+					close();
+					ensure(!"mmap failed");
+				}
+				p = q;
+				n = size;
+				::madvise(p, n, MADV_SEQUENTIAL);
+			}
+#endif
+		}
+		memory_map(const memory_map&) = delete;
+		memory_map& operator=(const memory_map&) = delete;
+		memory_map(memory_map&& m) noexcept
+			: memory_map()
+		{
+			swap(m);
+		}
+		memory_map& operator=(memory_map&& m) noexcept
+		{
+			if (this != &m) {
+				close();
+				swap(m);
+			}
+
+			return *this;
+		}
+		~memory_map()
+		{
+			close();
+		}
+
+		// Zero filled read write memory shared with child processes.
+		static memory_map shared(size_t size)
+		{
+			memory_map m;
+			ensure(size > 0);
+#ifdef _WIN32
+			ULARGE_INTEGER li;
+			li.QuadPart = size;
+			m.hm = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, li.HighPart, li.LowPart, NULL);
+			m.p = m.hm ? MapViewOfFile(m.hm, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+			ensure(m.p);
+#else
+			void* q = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+			ensure(q != MAP_FAILED);
+			m.p = q;
+#endif
+			m.n = size;
+
+			return m;
+		}
+
+		// Named read write memory shared with other processes. Create it zero filled with
+		// size bytes, failing if it exists, or open an existing one if size is 0.
+		// POSIX names start with '/'. The creator should remove it with unlink(name).
+		static memory_map shared(const char* name, size_t size)
+		{
+			memory_map m;
+#ifdef _WIN32
+			if (size > 0) {
+				ULARGE_INTEGER li;
+				li.QuadPart = size;
+				m.hm = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, li.HighPart, li.LowPart, name);
+				ensure(m.hm and GetLastError() != ERROR_ALREADY_EXISTS);
+			}
+			else {
+				m.hm = OpenFileMappingA(FILE_MAP_WRITE, FALSE, name);
+				ensure(m.hm);
+			}
+			m.p = MapViewOfFile(m.hm, FILE_MAP_WRITE, 0, 0, size);
+			ensure(m.p);
+			if (size == 0) {
+				MEMORY_BASIC_INFORMATION mbi;
+				VirtualQuery(m.p, &mbi, sizeof(mbi));
+				size = mbi.RegionSize;
+			}
+#else
+			m.fd = ::shm_open(name, size > 0 ? O_RDWR | O_CREAT | O_EXCL : O_RDWR, 0600);
+			ensure(m.fd != -1);
+			if (size > 0) {
+				if (::ftruncate(m.fd, static_cast<off_t>(size)) != 0) {
+					::shm_unlink(name);
+					ensure(!"ftruncate failed");
+				}
+			}
+			else {
+				struct stat st;
+				ensure(::fstat(m.fd, &st) == 0);
+				size = static_cast<size_t>(st.st_size);
+				ensure(size > 0);
+			}
+			void* q = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m.fd, 0);
+			ensure(q != MAP_FAILED);
+			m.p = q;
+#endif
+			m.n = size;
+
+			return m;
+		}
+		// Remove a name created by shared(name, size). Mappings stay valid.
+		static void unlink(const char* name) noexcept
+		{
+#ifndef _WIN32
+			::shm_unlink(name);
+#else
+			(void)name; // the mapping goes away with its last handle
+#endif
+		}
+
+		void swap(memory_map& m) noexcept
+		{
+			std::swap(p, m.p);
+			std::swap(n, m.n);
+#ifdef _WIN32
+			std::swap(h, m.h);
+			std::swap(hm, m.hm);
+#else
+			std::swap(fd, m.fd);
+#endif
+		}
+
+		// bytes mapped
+		size_t size() const noexcept
+		{
+			return n;
+		}
+		void* data() noexcept
+		{
+			return p;
+		}
+		const void* data() const noexcept
+		{
+			return p;
+		}
+		// number of whole T in the mapping
+		template<class T>
+		size_t count() const noexcept
+		{
+			return n / sizeof(T);
+		}
+		template<class T>
+		T* as() noexcept
+		{
+			return static_cast<T*>(p);
+		}
+		template<class T>
+		const T* as() const noexcept
+		{
+			return static_cast<const T*>(p);
+		}
+	};
+
+}
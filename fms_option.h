@@ -7,7 +7,9 @@
 #include <concepts>
 #include <functional>
 #include <limits>
+#include <type_traits>
 #include "fms_ensure.h"
+#include "fms_instrument.h"
 #include "fms_payoff.h"
 
 namespace fms {
@@ -18,6 +20,20 @@ namespace fms {
 		class X = std::common_type_t<F, S>>
 	class option {
 		const M& m;
+
+		// model calls go through these so they can be counted
+		X cdf(X x, S s = 0, size_t n = 0) const
+		{
+			instrument::count(instrument::cdf);
+
+			return m.cdf(x, s, n);
+		}
+		S cumulant(S s, size_t n = 0) const
+		{
+			instrument::count(instrument::cumulant);
+
+			return m.cumulant(s, n);
+		}
 	public:
 		option(const M& m)
 			: m(m)
@@ -33,8 +49,17 @@ namespace fms {
 			ensure(f > 0);
 			ensure(s > 0);
 			ensure(k > 0);
+			instrument::count(instrument::moneyness);
 
-			return (::log(k / f) + m.cumulant(s)) / s;
+			return (::log(k / f) + cumulant(s)) / s;
+		}
+		// given kappa = cumulant(s) for strips
+		template<class K>
+		X moneyness(F f, S s, K k, S kappa) const
+		{
+			instrument::count(instrument::moneyness);
+
+			return (::log(k / f) + kappa) / s;
 		}
 
 #pragma region value
@@ -42,7 +67,7 @@ namespace fms {
 		template<class K>
 		X value(F f, S s, const payoff::call<K>& c) const
 		{
-			K k = ::abs(c.strike);
+			K k = ::fabs(c.strike);
 
 			if (f == 0) {
 				return X(0);
@@ -56,13 +81,13 @@ namespace fms {
 
 			X x = moneyness(f, s, k);
 
-			return f * (1 - m.cdf(x, s)) - k * (1 - m.cdf(x));
+			return f * (1 - cdf(x, s)) - k * (1 - cdf(x));
 		}
 
 		template<class K>
 		X value(F f, S s, const payoff::put<K>& p) const
 		{
-			auto k = abs(p.strike);
+			K k = ::fabs(p.strike);
 
 			if (f == 0) {
 				return X(0);
@@ -76,10 +101,11 @@ namespace fms {
 
 			X x = moneyness(f, s, k);
 
-			return k * m.cdf(x) - f * m.cdf(x, s);
+			return k * cdf(x) - f * cdf(x, s);
 		}
 		// use negative strike for put
 		template<class K>
+			requires std::is_arithmetic_v<K>
 		X value(F f, S s, K k) const
 		{
 			return k > 0 ? value(f, s, payoff::call(k)) : value(f, s, payoff::put(-k));
@@ -102,7 +128,7 @@ namespace fms {
 
 			X x = moneyness(f, s, k);
 
-			return 1 - m.cdf(x);
+			return 1 - cdf(x);
 		}
 
 		template<class K>
@@ -122,7 +148,7 @@ namespace fms {
 
 			X x = moneyness(f, s, k);
 
-			return m.cdf(x);
+			return cdf(x);
 		}
 
 #pragma endregion // value
@@ -132,7 +158,7 @@ namespace fms {
 		template<class K>
 		X delta(F f, S s, const payoff::call<K>& c) const
 		{
-			K k = ::abs(c.strike);
+			K k = ::fabs(c.strike);
 
 			if (f == 0) {
 				return X(0);
@@ -146,12 +172,12 @@ namespace fms {
 
 			X x = moneyness(f, s, k);
 
-			return X(1) - m.cdf(x, s);
+			return X(1) - cdf(x, s);
 		}
 		template<class K>
 		X delta(F f, S s, const payoff::put<K>& p) const
 		{
-			K k = ::abs(p.strike);
+			K k = ::fabs(p.strike);
 
 			if (f == 0) {
 				return X(0);
@@ -165,10 +191,11 @@ namespace fms {
 
 			X x = moneyness(f, s, k);
 
-			return -m.cdf(x, s);
+			return -cdf(x, s);
 		}
 		// negative strike indicates put
 		template<class K>
+			requires std::is_arithmetic_v<K>
 		X delta(F f, S s, K k) const
 		{
 			return k > 0 ? delta(f, s, payoff::call(k)) : delta(f, s, payoff::put(-k));
@@ -196,7 +223,7 @@ namespace fms {
 
 			X x = moneyness(f, s, k);
 
-			return -m.cdf(x, 0, 1)/(f*s);
+			return -cdf(x, 0, 1)/(f*s);
 		}
 
 #pragma endregion // delta
@@ -205,9 +232,10 @@ namespace fms {
 
 		// c = p + f - k so d^2c/df^2 = d^2p/df^2
 		template<class K>
+			requires std::is_arithmetic_v<K>
 		X gamma(F f, S s, K k) const
 		{
-			k = ::abs(k);
+			k = ::fabs(k);
 
 			if (f == 0 or k == 0) {
 				return X(0);
@@ -218,7 +246,7 @@ namespace fms {
 
 			X x = moneyness(f, s, k);
 
-			return m.cdf(x, s, 1) / (f * s);
+			return cdf(x, s, 1) / (f * s);
 		}
 		template<class K>
 		X gamma(F f, S s, const payoff::call<K>& c) const
@@ -253,7 +281,8 @@ namespace fms {
 
 			X x = moneyness(f, s, k);
 
-			return (m.cdf(x, 0, 1) * s - m.cdf(x, 0, 2)) / (f * f * s * s);
+			// d/df -p(x)/(f s) with dx/df = -1/(f s)
+			return (cdf(x, 0, 1) * s + cdf(x, 0, 2)) / (f * f * s * s);
 		}
 
 #pragma endregion // gamma
@@ -262,13 +291,18 @@ namespace fms {
 
 		// f - k = c - p so dc/ds = dp/ds
 		template<class K>
+			requires std::is_arithmetic_v<K>
 		X vega(F f, S s, K k) const
 		{
-			k = ::abs(k);
+			k = ::fabs(k);
+
+			if (f == 0 or k == 0) {
+				return X(0);
+			}
 
 			auto x = moneyness(f, s, k);
 
-			return -f * m.edf(s, x); 
+			return -f * m.edf(x, s);
 		}
 		template<class K>
 		X vega(F f, S s, const payoff::call<K>& c) const
@@ -300,12 +334,312 @@ namespace fms {
 
 			X x = moneyness(f, s, k);
 
-			return -m.cdf(x, 0, 1)*(x - s)/s;
+			// dx/ds = (kappa'(s) - x)/s
+			return cdf(x, 0, 1)*(cumulant(s, 1) - x)/s;
 		}
 
 
 #pragma endregion // vega
 
+#pragma region strip
+
+		// Value n options with strike k[i], negative for put, computing cumulant(s) once.
+		template<class K>
+		void value(F f, S s, size_t n, const K* k, X* v) const
+		{
+			if (f == 0 or s == 0) {
+				for (size_t i = 0; i < n; ++i) {
+					v[i] = value(f, s, k[i]);
+				}
+
+				return;
+			}
+			ensure(f > 0);
+			ensure(s > 0);
+
+			instrument::timer t_(instrument::strip);
+			S kappa = cumulant(s);
+			for (size_t i = 0; i < n; ++i) {
+				K k_ = ::fabs(k[i]);
+				if (k_ == 0) {
+					v[i] = value(f, s, k[i]);
+					continue;
+				}
+
+				X x = moneyness(f, s, k_, kappa);
+				if (k[i] > 0) {
+					v[i] = f * (1 - cdf(x, s)) - k_ * (1 - cdf(x));
+				}
+				else {
+					v[i] = k_ * cdf(x) - f * cdf(x, s);
+				}
+			}
+		}
+
+		// Gamma of n options with strike k[i] computing cumulant(s) once.
+		template<class K>
+		void gamma(F f, S s, size_t n, const K* k, X* g) const
+		{
+			if (f == 0 or s == 0) {
+				for (size_t i = 0; i < n; ++i) {
+					g[i] = gamma(f, s, k[i]);
+				}
+
+				return;
+			}
+			ensure(f > 0);
+			ensure(s > 0);
+
+			instrument::timer t_(instrument::strip);
+			S kappa = cumulant(s);
+			for (size_t i = 0; i < n; ++i) {
+				K k_ = ::fabs(k[i]);
+				g[i] = k_ == 0 ? X(0) : cdf(moneyness(f, s, k_, kappa), s, 1) / (f * s);
+			}
+		}
+
+		// Vega of n options with strike k[i] computing cumulant(s) once.
+		template<class K>
+		void vega(F f, S s, size_t n, const K* k, X* v) const
+		{
+			if (f == 0 or s == 0) {
+				for (size_t i = 0; i < n; ++i) {
+					v[i] = vega(f, s, k[i]);
+				}
+
+				return;
+			}
+			ensure(f > 0);
+			ensure(s > 0);
+
+			instrument::timer t_(instrument::strip);
+			S kappa = cumulant(s);
+			for (size_t i = 0; i < n; ++i) {
+				K k_ = ::fabs(k[i]);
+				v[i] = k_ == 0 ? X(0) : -f * m.edf(moneyness(f, s, k_, kappa), s);
+			}
+		}
+
+		// Digital put values of n strikes k[i], the cdf of the forward, computing cumulant(s) once.
+		template<class K>
+		void digital_put(F f, S s, size_t n, const K* k, X* v) const
+		{
+			if (f == 0 or s == 0) {
+				for (size_t i = 0; i < n; ++i) {
+					v[i] = value(f, s, payoff::digital_put(k[i]));
+				}
+
+				return;
+			}
+			ensure(f > 0);
+			ensure(s > 0);
+
+			instrument::timer t_(instrument::strip);
+			S kappa = cumulant(s);
+			for (size_t i = 0; i < n; ++i) {
+				v[i] = k[i] == 0 ? X(0) : cdf(moneyness(f, s, k[i], kappa));
+			}
+		}
+
+		// Static replication using one pair of cdf calls per breakpoint.
+		// Breakpoints below the forward use puts and parity to avoid cancellation.
+		template<class K>
+		X value(F f, S s, const payoff::piecewise_linear<K>& g) const
+		{
+			if (f == 0 or s == 0) {
+				return g(f);
+			}
+			ensure(f > 0);
+			ensure(s > 0);
+
+			instrument::timer t_(instrument::strip);
+			S kappa = cumulant(s);
+			X v = g.level + g.slope[0] * f;
+			for (size_t i = 0; i < g.size(); ++i) {
+				K k = g.strike[i];
+				K db = g.slope[i + 1] - g.slope[i];
+				if (db == 0 and g.jump[i] == 0) {
+					continue;
+				}
+
+				X x = moneyness(f, s, k, kappa);
+				X P = cdf(x);
+				if (db != 0) {
+					X Ps = cdf(x, s);
+					v += db * (k < f ? k * P - f * Ps + f - k : f * (1 - Ps) - k * (1 - P));
+				}
+				v += g.jump[i] * (1 - P);
+			}
+
+			return v;
+		}
+		template<class K>
+		X delta(F f, S s, const payoff::piecewise_linear<K>& g) const
+		{
+			if (f == 0 or s == 0) {
+				X d = g.slope[0];
+				for (size_t i = 0; i < g.size() and g.strike[i] < f; ++i) {
+					d += g.slope[i + 1] - g.slope[i];
+				}
+
+				return d;
+			}
+			ensure(f > 0);
+			ensure(s > 0);
+
+			instrument::timer t_(instrument::strip);
+			S kappa = cumulant(s);
+			X d = g.slope[0];
+			for (size_t i = 0; i < g.size(); ++i) {
+				K db = g.slope[i + 1] - g.slope[i];
+				if (db == 0 and g.jump[i] == 0) {
+					continue;
+				}
+
+				X x = moneyness(f, s, g.strike[i], kappa);
+				if (db != 0) {
+					d += db * (1 - cdf(x, s));
+				}
+				if (g.jump[i] != 0) {
+					d += g.jump[i] * cdf(x, 0, 1) / (f * s);
+				}
+			}
+
+			return d;
+		}
+		template<class K>
+		X gamma(F f, S s, const payoff::piecewise_linear<K>& g) const
+		{
+			if (f == 0 or s == 0) {
+				return X(0);
+			}
+			ensure(f > 0);
+			ensure(s > 0);
+
+			instrument::timer t_(instrument::strip);
+			S kappa = cumulant(s);
+			X G = 0;
+			for (size_t i = 0; i < g.size(); ++i) {
+				K db = g.slope[i + 1] - g.slope[i];
+				if (db == 0 and g.jump[i] == 0) {
+					continue;
+				}
+
+				X x = moneyness(f, s, g.strike[i], kappa);
+				if (db != 0) {
+					G += db * cdf(x, s, 1) / (f * s);
+				}
+				if (g.jump[i] != 0) {
+					G -= g.jump[i] * (cdf(x, 0, 1) * s + cdf(x, 0, 2)) / (f * f * s * s);
+				}
+			}
+
+			return G;
+		}
+
+		// Multi-leg strategies share one moneyness and cdf pair per strike.
+		// Legs below the forward are valued as puts and above as calls using parity.
+		template<class K, size_t N>
+		X value(F f, S s, const payoff::strategy<K, N>& p) const
+		{
+			if (f == 0 or s == 0) {
+				return p(f);
+			}
+			ensure(f > 0);
+			ensure(s > 0);
+
+			instrument::timer t_(instrument::strip);
+			S kappa = cumulant(s);
+			X v = 0;
+			for (size_t i = 0; i < N; ++i) {
+				K k = p.strike[i];
+				K w = p.call[i] + p.put[i];
+				X x = moneyness(f, s, k, kappa);
+				if (k < f) {
+					v += p.call[i] * (f - k);
+					if (w != 0) {
+						v += w * (k * cdf(x) - f * cdf(x, s));
+					}
+				}
+				else {
+					v += p.put[i] * (k - f);
+					if (w != 0) {
+						v += w * (f * (1 - cdf(x, s)) - k * (1 - cdf(x)));
+					}
+				}
+			}
+
+			return v;
+		}
+		template<class K, size_t N>
+		X delta(F f, S s, const payoff::strategy<K, N>& p) const
+		{
+			X d = 0;
+
+			if (f == 0 or s == 0) {
+				for (size_t i = 0; i < N; ++i) {
+					d += f > p.strike[i] ? p.call[i] : -p.put[i];
+				}
+
+				return d;
+			}
+			ensure(f > 0);
+			ensure(s > 0);
+
+			instrument::timer t_(instrument::strip);
+			S kappa = cumulant(s);
+			for (size_t i = 0; i < N; ++i) {
+				K w = p.call[i] + p.put[i];
+				d += p.call[i];
+				if (w != 0) {
+					d -= w * cdf(moneyness(f, s, p.strike[i], kappa), s);
+				}
+			}
+
+			return d;
+		}
+		template<class K, size_t N>
+		X gamma(F f, S s, const payoff::strategy<K, N>& p) const
+		{
+			if (f == 0 or s == 0) {
+				return X(0);
+			}
+			ensure(f > 0);
+			ensure(s > 0);
+
+			instrument::timer t_(instrument::strip);
+			S kappa = cumulant(s);
+			X g = 0;
+			for (size_t i = 0; i < N; ++i) {
+				K w = p.call[i] + p.put[i];
+				if (w != 0) {
+					g += w * cdf(moneyness(f, s, p.strike[i], kappa), s, 1);
+				}
+			}
+
+			return g / (f * s);
+		}
+		template<class K, size_t N>
+		X vega(F f, S s, const payoff::strategy<K, N>& p) const
+		{
+			ensure(f > 0);
+			ensure(s > 0);
+
+			instrument::timer t_(instrument::strip);
+			S kappa = cumulant(s);
+			X v = 0;
+			for (size_t i = 0; i < N; ++i) {
+				K w = p.call[i] + p.put[i];
+				if (w != 0) {
+					v += w * m.edf(moneyness(f, s, p.strike[i], kappa), s);
+				}
+			}
+
+			return -f * v;
+		}
+
+#pragma endregion // strip
+
 		/*
 		// If we know the implied vol is s then if v > v0 where v0 is
 		// the at-the-money value it must be a call if f > k and a put
@@ -334,14 +668,13 @@ namespace fms {
 			ensure(v > 0);
 			static constexpr S epsilon = std::numeric_limits<S>::epsilon();
 
-			if (s == 0) {
-				F c = value(f, s, f);
-				s = 2.5 * c / f;
-			}
 			if (k < 0) {
 				k = -k;
 				v = f - k + v;
 			}
+			if (s == 0) { // Brenner-Subrahmanyam on the time value
+				s = S(2.5 * (v - (std::max)(f - k, F(0))) / f);
+			}
 			if (n == 0) {
 				n = 100;
 			}
@@ -352,6 +685,7 @@ namespace fms {
 				eps = 10 * epsilon;
 			}
 
+			size_t n0 = n;
 			S s_ = s + 2 * eps;
 			while (fabs(s_ - s) > eps) {
 				s_ = improve(s, f, v, k);
@@ -360,10 +694,238 @@ namespace fms {
 					break;
 				}
 			}
+			if (n == 0) {
+				instrument::count(instrument::implied_fail);
+			}
 			ensure(n != 0);
+			instrument::count(instrument::implied);
+			instrument::iterations(n0 - n);
 
 			return s_;
 		}
+
+#pragma region implied (batch)
+
+		// Largest vol the model allows, e.g. logistic cumulants need |s| < pi/sqrt(3).
+		static constexpr S vol_max() noexcept
+		{
+			if constexpr (requires { M::vol_max; }) {
+				return S(M::vol_max);
+			}
+			else {
+				return std::numeric_limits<S>::infinity();
+			}
+		}
+
+		// Implied vols s[i] of n quotes with strike k[i], negative for put, and value v[i].
+		// Quotes should be sorted by strike since each solve starts from the previous
+		// solution, or s[0] if it is positive. Models without edf use secant steps.
+		// Quotes with no solution are NaN. Returns the total number of iterations.
+		template<class K>
+		size_t implied(F f, size_t n, const K* k, const S* v, S* s, S eps = 0, size_t iter = 0) const
+		{
+			instrument::timer t_(instrument::implied_chain);
+			size_t m_ = 0;
+			warm w(n > 0 ? s[0] : 0);
+
+			for (size_t i = 0; i < n; ++i) {
+				K k_ = ::fabs(k[i]);
+				S c = k[i] < 0 ? f - k_ + v[i] : v[i]; // call value
+				S z = S(::log(k_ / f));
+
+				s[i] = std::numeric_limits<S>::quiet_NaN();
+				if (!(c > (std::max)(f - k_, F(0)) and c < f)) {
+					continue;
+				}
+				S s0 = w.guess(z);
+				if (!(s0 > 0)) {
+					s0 = (std::max)(S(2.5 * (c - (std::max)(f - k_, F(0))) / f), ::sqrt(2 * ::fabs(z)));
+				}
+
+				// call value is increasing in s since vega = -f edf and edf is a covariance of 1(X <= x) and X
+				auto r = [&](S s_) { return value(f, s_, payoff::call(k_)) - c; };
+				if constexpr (requires (const M& m_, X x_, S s_) { m_.edf(x_, s_); }) {
+					m_ += solve(r, [&](S s_) { return vega(f, s_, k_); }, s0, eps, iter, c, true);
+				}
+				else {
+					m_ += solve(r, nullptr, s0, eps, iter, c, true);
+				}
+				// failed solves are not warm starts
+				if (s0 > 0) {
+					w.update(z, s0);
+					s[i] = s0;
+				}
+			}
+
+			return m_;
+		}
+		template<class K>
+		size_t implied(F f, size_t n, const payoff::digital_call<K>* p, const S* v, S* s, S eps = 0, size_t iter = 0) const
+		{
+			return implied_digital(f, n, p, v, s, eps, iter);
+		}
+		template<class K>
+		size_t implied(F f, size_t n, const payoff::digital_put<K>* p, const S* v, S* s, S eps = 0, size_t iter = 0) const
+		{
+			return implied_digital(f, n, p, v, s, eps, iter);
+		}
+
+#pragma endregion // implied (batch)
+
+	private:
+		// Warm start from the last three solutions, quadratic in log strike.
+		struct warm {
+			S z[3], s[3]; // most recent first, s = 0 if none
+
+			warm(S s0)
+				: z{ 0, 0, 0 }, s{ s0 > 0 ? s0 : 0, 0, 0 }
+			{ }
+			S guess(S z_) const
+			{
+				size_t n = s[0] == 0 ? 0 : s[1] == 0 ? 1 : s[2] == 0 ? 2 : 3;
+
+				// Lagrange interpolation through (z[i], s[i]), i < n
+				S s_ = 0;
+				for (size_t i = 0; i < n; ++i) {
+					S l = s[i];
+					for (size_t j = 0; j < n; ++j) {
+						if (j != i) {
+							if (z[i] == z[j]) {
+								return s[0];
+							}
+							l *= (z_ - z[j]) / (z[i] - z[j]);
+						}
+					}
+					s_ += l;
+				}
+
+				return s_ > 0 ? s_ : s[0];
+			}
+			// s_ = 0 if the solve failed
+			void update(S z_, S s_)
+			{
+				z[2] = z[1];
+				s[2] = s_ > 0 ? s[1] : 0;
+				z[1] = z[0];
+				s[1] = s_ > 0 ? s[0] : 0;
+				z[0] = z_;
+				s[0] = s_;
+			}
+		};
+
+		// Solve r(s) = 0 on (0, vol_max()) starting at s using Newton-Raphson steps,
+		// or secant steps if dr is nullptr. Steps leaving the bracket of the root bisect.
+		// If r is increasing the bracket does not depend on the slope, which is zero up to
+		// rounding where a discrete model is flat in s. Converged steps must also have a
+		// residual within eps max(1, |v|), with v the value matched, or within a Newton step
+		// of eps, so values the model cannot reach fail instead of returning the closest vol.
+		// Returns the number of iterations with s the root, or s = 0 if it fails.
+		template<class R, class D>
+		static size_t solve(const R& r, const D& dr, S& s, S eps, size_t n, S v, bool increasing = false)
+		{
+			static constexpr S epsilon = std::numeric_limits<S>::epsilon();
+
+			if (n == 0) {
+				n = 100;
+			}
+			if (eps == 0) {
+				eps = ::sqrt(epsilon);
+			}
+
+			S lo = 0, hi = vol_max();
+			if (!(s < hi)) {
+				s = hi / 2;
+			}
+
+			S s_ = 0, r_ = 0; // previous iterate for secant steps
+			for (size_t i = 1; i <= n; ++i) {
+				S ri = r(s);
+				if (ri == 0) {
+					instrument::count(instrument::implied);
+					instrument::iterations(i);
+
+					return i;
+				}
+
+				S d;
+				if constexpr (std::is_null_pointer_v<D>) {
+					if (i == 1) {
+						S h = s / 1024;
+						d = (r(s + h) - ri) / h;
+					}
+					else {
+						d = (ri - r_) / (s - s_);
+					}
+				}
+				else {
+					d = dr(s);
+				}
+
+				// the root is below s if r is increasing and positive or decreasing and negative
+				if (increasing ? ri > 0 : ri * d > 0) {
+					hi = s;
+				}
+				else {
+					lo = s;
+				}
+
+				S s1 = s - ri / d;
+				if (!(lo < s1 and s1 < hi) or (increasing and !(d > 0))) {
+					s1 = hi < std::numeric_limits<S>::infinity() ? (lo + hi) / 2 : 2 * s;
+				}
+
+				s_ = s;
+				r_ = ri;
+				s = s1;
+				if (::fabs(s - s_) <= eps) {
+					if (!(::fabs(ri) <= eps * (std::max)(S(1), S(::fabs(v))) or ::fabs(ri) <= 2 * eps * ::fabs(d))) {
+						instrument::count(instrument::implied_fail);
+						s = 0;
+
+						return i;
+					}
+					instrument::count(instrument::implied);
+					instrument::iterations(i);
+
+					return i;
+				}
+			}
+			instrument::count(instrument::implied_fail);
+			s = 0;
+
+			return n;
+		}
+
+		template<class P>
+		size_t implied_digital(F f, size_t n, const P* p, const S* v, S* s, S eps, size_t iter) const
+		{
+			instrument::timer t_(instrument::implied_chain);
+			size_t m_ = 0;
+			warm w(n > 0 ? s[0] : 0);
+
+			for (size_t i = 0; i < n; ++i) {
+				S z = S(::log(p[i].strike / f));
+
+				s[i] = std::numeric_limits<S>::quiet_NaN();
+				if (!(0 < v[i] and v[i] < 1)) {
+					continue;
+				}
+				S s0 = w.guess(z);
+				if (!(s0 > 0)) {
+					// below the vol sqrt(2|z|) where the normal digital value is extreme
+					s0 = (std::max)(S(::sqrt(2 * ::fabs(z)) / 2), S(0.1));
+				}
+
+				m_ += solve([&](S s_) { return value(f, s_, p[i]) - v[i]; },
+					[&](S s_) { return vega(f, s_, p[i]); }, s0, eps, iter, v[i]);
+				if (s0 > 0) {
+					w.update(z, s0);
+					s[i] = s0;
+				}
+			}
+
+			return m_;
+		}
 	};
 
 }
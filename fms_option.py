@@ -0,0 +1,135 @@
+# fms_option.py - Python front end to the fmsoption shared library
+# Arrays are passed to the library in place: anything with __array_interface__,
+# such as NumPy float64 arrays, with its own strides, otherwise any contiguous
+# buffer of doubles such as array('d'). Python floats are broadcast with stride 0.
+# Read only buffers other than arrays, such as bytes, are copied since ctypes can only
+# take the address of a writable buffer. Outputs must be writable.
+#
+#   from fms_option import model
+#   N = model.normal()
+#   v = N.value(100, 0.2, k)   # k a 1-d float64 array, v is a new array like k
+#   N.implied(100, v, k, out=v) # in place
+import ctypes
+import os
+import sys
+from array import array
+
+_name = {"win32": "fmsoption.dll", "darwin": "libfmsoption.dylib"}.get(sys.platform, "libfmsoption.so")
+_lib = ctypes.CDLL(os.environ.get("FMS_OPTION_LIB", os.path.join(os.path.dirname(os.path.abspath(__file__)), _name)))
+
+_p = ctypes.c_void_p
+_n = ctypes.c_size_t
+_d = ctypes.c_ssize_t
+_native = "<" if sys.byteorder == "little" else ">"
+
+_lib.fms_model_normal.restype = _p
+_lib.fms_model_normal.argtypes = [ctypes.c_double, ctypes.c_double]
+_lib.fms_model_discrete.restype = _p
+_lib.fms_model_discrete.argtypes = [_n, _p, _p]
+_lib.fms_model_free.restype = None
+_lib.fms_model_free.argtypes = [_p]
+_lib.fms_error.restype = ctypes.c_char_p
+_lib.fms_error.argtypes = []
+_lib.fms_price.restype = _d
+_lib.fms_price.argtypes = [_p, ctypes.c_int, ctypes.c_int, _n, _p, _d, _p, _d, _p, _d, _p, _d]
+
+# same values as fms_option_c.h
+VANILLA, DIGITAL_CALL, DIGITAL_PUT = 0, 1, 2
+VALUE, DELTA, GAMMA, VEGA, IMPLIED = 0, 1, 2, 3, 4
+
+
+class _arg:
+    """Pointer, stride in bytes, and length of a double argument, None length for scalars."""
+
+    def __init__(self, x, writable=False):
+        self.keep = x
+        if isinstance(x, (int, float)) and not writable:
+            self.keep = ctypes.c_double(x)
+            self.ptr, self.stride, self.size = ctypes.addressof(self.keep), 0, None
+        elif hasattr(x, "__array_interface__"):
+            a = x.__array_interface__
+            if a["typestr"] not in (_native + "f8", "=f8"):
+                raise TypeError("arrays must be float64 in native byte order")
+            if len(a["shape"]) != 1:
+                raise TypeError("arrays must be 1-d")
+            if writable and a["data"][1]:
+                raise TypeError("out is read only")
+            self.ptr = a["data"][0]
+            self.stride = a["strides"][0] if a.get("strides") else 8
+            self.size = a["shape"][0]
+        else:
+            m = memoryview(x)
+            if m.format not in ("d", "@d", "=d", _native + "d") or m.ndim != 1 or not m.c_contiguous:
+                raise TypeError("buffers must be contiguous doubles")
+            if m.readonly:
+                if writable:
+                    raise TypeError("out is read only")
+                # ctypes only takes the address of writable buffers
+                self.keep = (ctypes.c_double * len(m)).from_buffer_copy(m)
+            else:
+                self.keep = (ctypes.c_double * len(m)).from_buffer(m)
+            self.ptr, self.stride, self.size = ctypes.addressof(self.keep), 8, len(m)
+
+
+class model:
+    """Handle to a model in the shared library."""
+
+    def __init__(self, handle):
+        if not handle:
+            raise ValueError(_lib.fms_error().decode())
+        self.handle = handle
+
+    def __del__(self):
+        if getattr(self, "handle", None):
+            _lib.fms_model_free(self.handle)
+            self.handle = None
+
+    @staticmethod
+    def normal(mu=0.0, sigma=1.0):
+        return model(_lib.fms_model_normal(mu, sigma))
+
+    @staticmethod
+    def discrete(x, p):
+        x_, p_ = _arg(x), _arg(p)
+        if x_.size is None or x_.size != p_.size or x_.stride != 8 or p_.stride != 8:
+            raise TypeError("atoms and probabilities must be contiguous arrays of the same length")
+        return model(_lib.fms_model_discrete(x_.size, x_.ptr, p_.ptr))
+
+    def price(self, w, f, s, k, kind=VANILLA, out=None):
+        """Measure w of options with forward f, vol s, and strike k, negative for put."""
+        f_, s_, k_ = _arg(f), _arg(s), _arg(k)
+        sizes = {a.size for a in (f_, s_, k_) if a.size is not None}
+        if len(sizes) > 1:
+            raise ValueError("array arguments must have the same length")
+        scalar = not sizes and out is None
+        n = sizes.pop() if sizes else 1
+        if out is None:
+            like = next((a.keep for a in (k_, s_, f_) if a.size is not None), None)
+            if hasattr(like, "__array_interface__"):
+                import numpy
+                out = numpy.empty(n)
+            else:
+                out = array("d", [0.0]) * n
+        o_ = _arg(out, writable=True)
+        if o_.size != n:
+            raise ValueError("out has the wrong length")
+        if _lib.fms_price(self.handle, w, kind, n, f_.ptr, f_.stride, s_.ptr, s_.stride, k_.ptr, k_.stride,
+                          o_.ptr, o_.stride) < 0:
+            raise ValueError(_lib.fms_error().decode())
+        return out[0] if scalar else out
+
+    def value(self, f, s, k, kind=VANILLA, out=None):
+        return self.price(VALUE, f, s, k, kind, out)
+
+    def delta(self, f, s, k, kind=VANILLA, out=None):
+        return self.price(DELTA, f, s, k, kind, out)
+
+    def gamma(self, f, s, k, kind=VANILLA, out=None):
+        return self.price(GAMMA, f, s, k, kind, out)
+
+    def vega(self, f, s, k, kind=VANILLA, out=None):
+        return self.price(VEGA, f, s, k, kind, out)
+
+    def implied(self, f, v, k, kind=VANILLA, out=None):
+        """Vol of options with forward f, value v, and strike k."""
+        return self.price(IMPLIED, f, v, k, kind, out)
@@ -2,9 +2,12 @@
 #include <cassert>
 #include <functional>
 #include <iostream>
+#include <tuple>
 #include <utility>
+#include <vector>
 #include "fms_test.h"
 #include "fms_option.h"
+#include "fms_variate_discrete.h"
 
 namespace fms::variate {
 
@@ -187,12 +190,284 @@ int test_implied()
 		X v = m.value(f, s, k);
 		s_ = m.implied(f, v, k);
 		s_ -= s;
+		assert(fabs(s_) < 1e-8);
 	}
 
 	return 0;
 }
 int test_implied_d = test_implied<double>();
 
+// normal without edf so implied uses secant steps
+template<class X = double, class S = X>
+struct normal_secant {
+	typedef X xtype;
+	typedef S stype;
+
+	static X cdf(X x, S s = 0, size_t n = 0)
+	{
+		return variate::normal<X, S>::cdf(x, s, n);
+	}
+	static S cumulant(S s, size_t n = 0)
+	{
+		return variate::normal<X, S>::cumulant(s, n);
+	}
+};
+
+template<class X>
+int test_implied_chain()
+{
+	constexpr size_t n = 41;
+	X f = 100;
+	X k[n], s[n], v[n], s_[n];
+
+	// smooth smile in log moneyness, puts below the forward
+	for (size_t i = 0; i < n; ++i) {
+		X z = X(-0.4) + X(0.02) * i;
+		k[i] = f * ::exp(z);
+		s[i] = X(0.2) + X(0.3) * z * z - X(0.1) * z;
+		if (k[i] < f) {
+			k[i] = -k[i];
+		}
+	}
+	{
+		variate::normal<X> N;
+		option m(N);
+
+		for (size_t i = 0; i < n; ++i) {
+			v[i] = m.value(f, s[i], k[i]);
+			s_[i] = 0;
+		}
+		size_t iter = m.implied(f, n, k, v, s_);
+		for (size_t i = 0; i < n; ++i) {
+			assert(fabs(s_[i] - s[i]) < 1e-8);
+		}
+		// warm starts take one or two iterations per quote
+		assert(iter <= 2 * n);
+	}
+	{
+		normal_secant<X> N;
+		option m(N);
+
+		for (size_t i = 0; i < n; ++i) {
+			v[i] = m.value(f, s[i], k[i]);
+			s_[i] = 0;
+		}
+		m.implied(f, n, k, v, s_, X(1e-10));
+		for (size_t i = 0; i < n; ++i) {
+			assert(fabs(s_[i] - s[i]) < 1e-8);
+		}
+	}
+	{
+		variate::normal<X> N;
+		option m(N);
+		std::vector<payoff::digital_call<X>> dc;
+		std::vector<payoff::digital_put<X>> dp;
+
+		for (size_t i = 0; i < n; ++i) {
+			dc.push_back(payoff::digital_call<X>(::fabs(k[i])));
+			dp.push_back(payoff::digital_put<X>(::fabs(k[i])));
+			v[i] = m.value(f, s[i], dc[i]);
+			s_[i] = 0;
+		}
+		m.implied(f, n, dc.data(), v, s_, X(1e-10));
+		for (size_t i = 0; i < n; ++i) {
+			// digital vega is 0 at s^2 = 2|log(k/f)| for the normal
+			if (fabs(s[i] * s[i] - 2 * fabs(::log(fabs(k[i]) / f))) > 0.01) {
+				assert(fabs(s_[i] - s[i]) < 1e-7);
+			}
+		}
+
+		for (size_t i = 0; i < n; ++i) {
+			v[i] = m.value(f, s[i], dp[i]);
+			s_[i] = 0;
+		}
+		m.implied(f, n, dp.data(), v, s_, X(1e-10));
+		for (size_t i = 0; i < n; ++i) {
+			// digital vega is 0 at s^2 = 2|log(k/f)| for the normal
+			if (fabs(s[i] * s[i] - 2 * fabs(::log(fabs(k[i]) / f))) > 0.01) {
+				assert(fabs(s_[i] - s[i]) < 1e-7);
+			}
+		}
+	}
+	{
+		// the digital call value at k = 122.14 peaks near 0.2635 so 0.4 has no vol and
+		// must not become the warm start for the next quote
+		variate::normal<X> N;
+		option m(N);
+		payoff::digital_call<X> dc[2] = { payoff::digital_call<X>(X(122.14)), payoff::digital_call<X>(X(122.14)) };
+		X vd[2] = { X(0.4), X(0.2) };
+		X s1 = 0;
+
+		m.implied(f, 1, dc + 1, vd + 1, &s1);
+		assert(fabs(s1 - X(0.286346)) < 1e-6);
+		s_[0] = 0;
+		m.implied(f, 2, dc, vd, s_);
+		assert(s_[0] != s_[0]);
+		assert(fabs(s_[1] - s1) < 1e-8);
+	}
+	{
+		// out of the money values are flat in s for small s so warm starts from unsorted
+		// strikes can land where the slope is 0
+		variate::discrete<X, X, 2> D({ -1, 1 }, { X(0.5), X(0.5) });
+		option m(D);
+		X kd[n];
+
+		for (size_t i = 0; i < n; ++i) {
+			kd[i] = X(80 + (i * 7) % 41);
+			v[i] = m.value(f, X(0.1) * (1 + i % 3), kd[i]);
+			s_[i] = 0;
+		}
+		m.implied(f, n, kd, v, s_);
+		for (size_t i = 0; i < n; ++i) {
+			if (v[i] > ::fmax(f - kd[i], X(0))) {
+				assert(fabs(m.value(f, s_[i], kd[i]) - v[i]) < 1e-8);
+			}
+		}
+	}
+	{
+		// no arbitrage free vol
+		variate::normal<X> N;
+		option m(N);
+		X k0 = 90, v0 = 5;
+		m.implied(f, 1, &k0, &v0, s_);
+		assert(s_[0] != s_[0]);
+	}
+
+	return 0;
+}
+int test_implied_chain_d = test_implied_chain<double>();
+
+template<class X>
+int test_option_strip()
+{
+	X f = 100;
+	X s = X(0.2);
+	variate::normal<X> N;
+	option m(N);
+	{
+		X k[] = { -80, -90, 100, 110, -120 };
+		X v[5];
+		m.value(f, s, 5, k, v);
+		for (size_t i = 0; i < 5; ++i) {
+			assert(fabs(v[i] - m.value(f, s, k[i])) < 1e-12);
+		}
+	}
+	{
+		// short put 90, long calls 100 and 110, digital 2 at 105
+		X k[] = { 90, 100, 105, 110 };
+		X b[] = { 1, 0, 1, 1, 2 };
+		X j[] = { 0, 0, 2, 0 };
+		payoff::piecewise_linear<X> g(-90, 4, k, b, j);
+		assert(g(0) == -90);
+		assert(g(95) == 0);
+		assert(g(106) == 6 + 2);
+
+		X v = -m.value(f, s, payoff::put(X(90))) + m.value(f, s, payoff::call(X(100)))
+			+ m.value(f, s, payoff::call(X(110))) + 2 * m.value(f, s, payoff::digital_call(X(105)));
+		assert(fabs(m.value(f, s, g) - v) < 1e-12);
+
+		auto v_ = [&](X x) { return m.value(x, s, g); };
+		auto d_ = [&](X x) { return m.delta(x, s, g); };
+		auto g_ = [&](X x) { return m.gamma(x, s, g); };
+		X dx = X(0.01);
+		auto [lo, hi] = test_derivative(v_, d_, dx, X(90), X(110), X(1));
+		assert(fabs(lo) < 10 * dx * dx);
+		assert(fabs(hi) < 10 * dx * dx);
+		std::tie(lo, hi) = test_derivative(d_, g_, dx, X(90), X(110), X(1));
+		assert(fabs(lo) < 10 * dx * dx);
+		assert(fabs(hi) < 10 * dx * dx);
+
+		assert(m.value(f, 0, g) == g(f));
+
+		// negative forward or vol throws like the other payoffs
+		for (auto [f_, s_] : { std::pair(-f, s), std::pair(f, -s) }) {
+			size_t thrown = 0;
+			for (const auto& h : { std::function<X()>([&] { return m.value(f_, s_, g); }),
+				std::function<X()>([&] { return m.delta(f_, s_, g); }),
+				std::function<X()>([&] { return m.gamma(f_, s_, g); }) }) {
+				try {
+					h();
+				}
+				catch (const std::exception&) {
+					++thrown;
+				}
+			}
+			assert(thrown == 3);
+		}
+	}
+
+	return 0;
+}
+int test_option_strip_d = test_option_strip<double>();
+
+// count cdf calls
+template<class X = double, class S = X>
+struct normal_count : variate::normal<X, S> {
+	mutable size_t n = 0;
+
+	X cdf(X x, S s = 0, size_t n_ = 0) const
+	{
+		++n;
+
+		return variate::normal<X, S>::cdf(x, s, n_);
+	}
+};
+
+template<class X>
+int test_option_strategy()
+{
+	X f = 100;
+	X s = X(0.2);
+	normal_count<X> N;
+	option m(N);
+	using payoff::call;
+	using payoff::put;
+
+	auto check = [&](const auto& p, X v) {
+		assert(fabs(m.value(f, s, p) - v) < 1e-12);
+
+		auto v_ = [&](X x) { return m.value(x, s, p); };
+		auto d_ = [&](X x) { return m.delta(x, s, p); };
+		auto g_ = [&](X x) { return m.gamma(x, s, p); };
+		auto w_ = [&](X x) { return m.value(f, x, p); };
+		auto e_ = [&](X x) { return m.vega(f, x, p); };
+		X dx = X(0.001);
+		auto [lo, hi] = test_derivative(v_, d_, dx, X(90), X(110), X(1));
+		assert(-1e-6 < lo and hi < 1e-6);
+		std::tie(lo, hi) = test_derivative(d_, g_, dx, X(90), X(110), X(1));
+		assert(-1e-6 < lo and hi < 1e-6);
+		std::tie(lo, hi) = test_derivative(w_, e_, dx / 10, X(0.1), X(0.3), X(0.01));
+		assert(-1e-4 < lo and hi < 1e-4);
+	};
+
+	check(payoff::straddle(X(100)), m.value(f, s, call(X(100))) + m.value(f, s, put(X(100))));
+	check(payoff::strangle(X(90), X(110)), m.value(f, s, put(X(90))) + m.value(f, s, call(X(110))));
+	check(payoff::call_spread(X(95), X(105)), m.value(f, s, call(X(95))) - m.value(f, s, call(X(105))));
+	check(payoff::put_spread(X(95), X(105)), m.value(f, s, put(X(105))) - m.value(f, s, put(X(95))));
+	check(payoff::risk_reversal(X(90), X(110)), m.value(f, s, call(X(110))) - m.value(f, s, put(X(90))));
+	check(payoff::butterfly(X(90), X(100), X(110)),
+		m.value(f, s, call(X(90))) - 2 * m.value(f, s, call(X(100))) + m.value(f, s, call(X(110))));
+	check(payoff::condor(X(80), X(90), X(110), X(120)),
+		m.value(f, s, call(X(80))) - m.value(f, s, call(X(90)))
+		- m.value(f, s, call(X(110))) + m.value(f, s, call(X(120))));
+
+	{
+		payoff::butterfly b(X(90), X(100), X(120));
+		assert(b(X(80)) == 0);
+		assert(b(X(100)) == 10);
+		assert(fabs(b(X(130))) < 1e-12);
+		assert(m.value(f, 0, b) == 10);
+	}
+	{
+		N.n = 0;
+		m.value(f, s, payoff::straddle(X(105)));
+		assert(N.n == 2);
+	}
+
+	return 0;
+}
+int test_option_strategy_d = test_option_strategy<double>();
+
 
 int main()
 {
@@ -0,0 +1,147 @@
+// fms_option_c.cpp - C interface to batch option pricing
+// Strided arguments are gathered into records of price::block at a time so every
+// front end gets the strip and chain batching of price::price.
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+#include "fms_option_c.h"
+#include "fms_price.h"
+#include "fms_variate_discrete.h"
+#include "fms_variate_normal.h"
+
+using namespace fms;
+
+// compiled once here for all front ends
+template class fms::option<variate::normal_impl<>>;
+template class fms::option<variate::discrete<>>;
+
+struct fms_model {
+	virtual ~fms_model() = default;
+	virtual void batch(price::measure w, size_t n, const price::record* r, double* out) const = 0;
+};
+
+namespace {
+
+	thread_local std::string error;
+
+	template<class M>
+	class model : public fms_model {
+		M m;
+		option<M> o;
+	public:
+		model(M m_)
+			: m(std::move(m_)), o(m)
+		{ }
+		model(const model&) = delete;
+		model& operator=(const model&) = delete;
+
+		void batch(price::measure w, size_t n, const price::record* r, double* out) const override
+		{
+			price::price(o, w, n, r, out);
+		}
+	};
+
+	template<class M>
+	inline fms_model* make(M m)
+	{
+		return new model<M>(std::move(m));
+	}
+
+	inline double at(const double* x, ptrdiff_t stride, size_t i)
+	{
+		return *reinterpret_cast<const double*>(reinterpret_cast<const char*>(x) + static_cast<ptrdiff_t>(i) * stride);
+	}
+	inline double& at(double* x, ptrdiff_t stride, size_t i)
+	{
+		return *reinterpret_cast<double*>(reinterpret_cast<char*>(x) + static_cast<ptrdiff_t>(i) * stride);
+	}
+}
+
+extern "C" {
+
+	fms_model* fms_model_normal(double mu, double sigma)
+	{
+		try {
+			error.clear();
+			ensure(sigma > 0);
+
+			return make(variate::normal_impl<>(mu, sigma));
+		}
+		catch (const std::exception& ex) {
+			error = ex.what();
+		}
+
+		return nullptr;
+	}
+
+	fms_model* fms_model_discrete(size_t n, const double* x, const double* p)
+	{
+		try {
+			error.clear();
+			ensure(n > 0 and x and p);
+
+			return make(variate::discrete<>(n, x, p));
+		}
+		catch (const std::exception& ex) {
+			error = ex.what();
+		}
+
+		return nullptr;
+	}
+
+	void fms_model_free(fms_model* m)
+	{
+		delete m;
+	}
+
+	const char* fms_error(void)
+	{
+		return error.c_str();
+	}
+
+	ptrdiff_t fms_price(const fms_model* m, fms_measure w, fms_kind p, size_t n,
+		const double* f, ptrdiff_t f_stride,
+		const double* s, ptrdiff_t s_stride,
+		const double* k, ptrdiff_t k_stride,
+		double* out, ptrdiff_t out_stride)
+	{
+		thread_local std::vector<price::record> r;
+		thread_local std::vector<double> v;
+
+		try {
+			error.clear();
+			ensure(m);
+			ensure(FMS_VALUE <= w and w <= FMS_IMPLIED);
+			ensure(FMS_VANILLA <= p and p <= FMS_DIGITAL_PUT);
+			ensure(n == 0 or (f and s and k and out));
+
+			r.resize((std::min)(n, price::block));
+			v.resize(r.size());
+
+			ptrdiff_t nan = 0;
+			for (size_t i = 0; i < n; i += price::block) {
+				size_t b = (std::min)(n - i, price::block);
+				for (size_t j = 0; j < b; ++j) {
+					r[j] = price::record{ at(f, f_stride, i + j), at(s, s_stride, i + j), at(k, k_stride, i + j),
+						static_cast<price::kind>(p), 0 };
+				}
+				m->batch(static_cast<price::measure>(w), b, r.data(), v.data());
+				for (size_t j = 0; j < b; ++j) {
+					at(out, out_stride, i + j) = v[j];
+					nan += std::isnan(v[j]);
+				}
+			}
+
+			return nan;
+		}
+		catch (const std::exception& ex) {
+			error = ex.what();
+		}
+
+		return -1;
+	}
+
+}
@@ -0,0 +1,62 @@
+/* fms_option_c.h - C interface to batch option pricing
+ * Models are opaque handles. Batches take strided arrays so front ends can pass
+ * their own buffers without copying: stride is in bytes between elements and a
+ * stride of 0 repeats the first element, e.g. for a common forward or vol.
+ * Build fms_option_c.cpp as a shared library with FMS_OPTION_C_EXPORTS defined, e.g.
+ *   g++ -std=c++20 -O2 -shared -fPIC -DFMS_OPTION_C_EXPORTS fms_option_c.cpp -o libfmsoption.so
+ */
+#pragma once
+#include <stddef.h>
+
+#ifdef _WIN32
+#ifdef FMS_OPTION_C_EXPORTS
+#define FMS_API __declspec(dllexport)
+#else
+#define FMS_API __declspec(dllimport)
+#endif
+#else
+#define FMS_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* same values as fms::price::kind */
+enum fms_kind {
+	FMS_VANILLA = 0, /* put if strike is negative */
+	FMS_DIGITAL_CALL = 1,
+	FMS_DIGITAL_PUT = 2,
+};
+
+/* same values as fms::price::measure */
+enum fms_measure {
+	FMS_VALUE = 0,
+	FMS_DELTA = 1,
+	FMS_GAMMA = 2,
+	FMS_VEGA = 3,
+	FMS_IMPLIED = 4, /* s is the option value */
+};
+
+typedef struct fms_model fms_model;
+
+/* Models return NULL on failure with the reason in fms_error(). */
+FMS_API fms_model* fms_model_normal(double mu, double sigma);
+/* n atoms x with probabilities p summing to 1 */
+FMS_API fms_model* fms_model_discrete(size_t n, const double* x, const double* p);
+FMS_API void fms_model_free(fms_model* m);
+
+/* Last error on this thread, or an empty string. */
+FMS_API const char* fms_error(void);
+
+/* Write measure w of n options of kind p with forward f, vol s, and strike k to out.
+ * Options that fail are NaN. Returns the number of NaN results or -1 on bad arguments. */
+FMS_API ptrdiff_t fms_price(const fms_model* m, enum fms_measure w, enum fms_kind p, size_t n,
+	const double* f, ptrdiff_t f_stride,
+	const double* s, ptrdiff_t s_stride,
+	const double* k, ptrdiff_t k_stride,
+	double* out, ptrdiff_t out_stride);
+
+#ifdef __cplusplus
+}
+#endif
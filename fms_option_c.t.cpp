@@ -0,0 +1,62 @@
+// fms_option_c.t.cpp - test the C interface
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "fms_option_c.h"
+#include "fms_price.h"
+#include "fms_variate_discrete.h"
+
+using namespace fms;
+
+int test_option_c()
+{
+	double x[] = { -1, 0, 1 };
+	double p[] = { 0.25, 0.5, 0.25 };
+	fms_model* m = fms_model_discrete(3, x, p);
+	assert(m and *fms_error() == 0);
+	variate::discrete<> D(3, x, p);
+	option o(D);
+
+	// strikes and values interleaved, common forward and vol
+	double f = 100, s = 0.2;
+	std::vector<double> kv = { -90, 0, -95, 0, 100, 0, 105, 0, 110, 0 };
+	size_t n = kv.size() / 2;
+	assert(0 == fms_price(m, FMS_VALUE, FMS_VANILLA, n, &f, 0, &s, 0, &kv[0], 2 * sizeof(double), &kv[1], 2 * sizeof(double)));
+	for (size_t i = 0; i < n; ++i) {
+		assert(kv[2 * i + 1] == o.value(f, s, kv[2 * i]));
+	}
+
+	// implied vol in place
+	std::vector<double> k(n), v(n);
+	for (size_t i = 0; i < n; ++i) {
+		k[i] = kv[2 * i];
+		v[i] = kv[2 * i + 1];
+	}
+	assert(0 == fms_price(m, FMS_IMPLIED, FMS_VANILLA, n, &f, 0, v.data(), sizeof(double), k.data(), sizeof(double), v.data(), sizeof(double)));
+	for (size_t i = 0; i < n; ++i) {
+		assert(fabs(v[i] - s) < 1e-8);
+	}
+
+	// failures are NaN
+	double F[] = { 100, -1 };
+	double d[2];
+	assert(1 == fms_price(m, FMS_DELTA, FMS_DIGITAL_CALL, 2, F, sizeof(double), &s, 0, &kv[4], 0, d, sizeof(double)));
+	assert(d[0] == price::price(o, price::measure::delta, f, s, payoff::digital_call(100.)));
+	assert(std::isnan(d[1]));
+
+	assert(-1 == fms_price(nullptr, FMS_VALUE, FMS_VANILLA, 1, &f, 0, &s, 0, &f, 0, d, 0));
+	assert(*fms_error() != 0);
+	assert(-1 == fms_price(m, static_cast<fms_measure>(7), FMS_VANILLA, 1, &f, 0, &s, 0, &f, 0, d, 0));
+	assert(0 == fms_price(m, FMS_VALUE, FMS_VANILLA, 0, nullptr, 0, nullptr, 0, nullptr, 0, nullptr, 0));
+	fms_model_free(m);
+
+	m = fms_model_normal(0, 1);
+	assert(0 == fms_price(m, FMS_VEGA, FMS_VANILLA, 1, &f, 0, &s, 0, &f, 0, d, 0));
+	assert(d[0] > 0);
+	fms_model_free(m);
+	assert(!fms_model_normal(0, -1));
+	assert(*fms_error() != 0);
+
+	return 0;
+}
+int test_option_c_ = test_option_c();
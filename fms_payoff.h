@@ -1,6 +1,10 @@
 // fms_option_payoff.h - standard option payoffs
 #pragma once
+#include <algorithm>
 #include <concepts>
+#include <cstddef>
+#include <vector>
+#include "fms_ensure.h"
 
 namespace fms::payoff {
 
@@ -15,21 +19,165 @@ namespace fms::payoff {
 	template<class K = double>
 	struct put : public option<K> {
 		put(K k) : option<K>{ k } { }
+
+		K operator()(K x) const noexcept
+		{
+			return (std::max)(this->strike - x, K(0));
+		}
 	};
 
 	template<class K = double>
 	struct call : public option<K> {
 		call(K k) : option<K>{ k } { }
+
+		K operator()(K x) const noexcept
+		{
+			return (std::max)(x - this->strike, K(0));
+		}
 	};
 
 	template<class K = double>
 	struct digital_call : public option<K> { 
 		digital_call(K k) : option<K>{ k } { }
+
+		K operator()(K x) const noexcept
+		{
+			return K(x > this->strike);
+		}
 	};
 
 	template<class K = double>
 	struct digital_put : public option<K> { 
 		digital_put(K k) : option<K>{ k } { }
+
+		K operator()(K x) const noexcept
+		{
+			return K(x <= this->strike);
+		}
+	};
+
+	// Calls and puts at N increasing strikes. By parity c = p + f - k the value is
+	// sum_i (c_i + p_i) put(k_i) + c_i (f - k_i) so each strike needs one moneyness.
+	template<class K, size_t N>
+		requires std::is_floating_point_v<K>
+	struct strategy {
+		typedef K type;
+		static constexpr size_t size = N;
+		K strike[N];
+		K call[N]; // number of calls at each strike
+		K put[N];  // number of puts at each strike
+
+		K operator()(K x) const noexcept
+		{
+			K g = 0;
+
+			for (size_t i = 0; i < N; ++i) {
+				g += call[i] * (std::max)(x - strike[i], K(0)) + put[i] * (std::max)(strike[i] - x, K(0));
+			}
+
+			return g;
+		}
+	};
+
+	template<class K = double>
+	struct straddle : public strategy<K, 1> {
+		straddle(K k) : strategy<K, 1>{ { k }, { 1 }, { 1 } } { }
+	};
+
+	// put at k0 and call at k1
+	template<class K = double>
+	struct strangle : public strategy<K, 2> {
+		strangle(K k0, K k1) : strategy<K, 2>{ { k0, k1 }, { 0, 1 }, { 1, 0 } }
+		{
+			ensure(k0 <= k1);
+		}
+	};
+
+	// long call at k0, short call at k1
+	template<class K = double>
+	struct call_spread : public strategy<K, 2> {
+		call_spread(K k0, K k1) : strategy<K, 2>{ { k0, k1 }, { 1, -1 }, { 0, 0 } }
+		{
+			ensure(k0 <= k1);
+		}
+	};
+
+	// short put at k0, long put at k1
+	template<class K = double>
+	struct put_spread : public strategy<K, 2> {
+		put_spread(K k0, K k1) : strategy<K, 2>{ { k0, k1 }, { 0, 0 }, { -1, 1 } }
+		{
+			ensure(k0 <= k1);
+		}
+	};
+
+	// short put at k0, long call at k1
+	template<class K = double>
+	struct risk_reversal : public strategy<K, 2> {
+		risk_reversal(K k0, K k1) : strategy<K, 2>{ { k0, k1 }, { 0, 1 }, { -1, 0 } }
+		{
+			ensure(k0 <= k1);
+		}
+	};
+
+	// Calls weighted so the payoff is 0 outside (k0, k2) with peak k1 - k0.
+	template<class K = double>
+	struct butterfly : public strategy<K, 3> {
+		butterfly(K k0, K k1, K k2)
+			: strategy<K, 3>{ { k0, k1, k2 }, { 1, -(k2 - k0) / (k2 - k1), (k1 - k0) / (k2 - k1) }, { 0, 0, 0 } }
+		{
+			ensure(k0 < k1 and k1 < k2);
+		}
+	};
+
+	// Long calls at k0 and k3, short calls at k1 and k2.
+	// The payoff is 0 above k3 if k1 - k0 = k3 - k2.
+	template<class K = double>
+	struct condor : public strategy<K, 4> {
+		condor(K k0, K k1, K k2, K k3)
+			: strategy<K, 4>{ { k0, k1, k2, k3 }, { 1, -1, -1, 1 }, { 0, 0, 0, 0 } }
+		{
+			ensure(k0 < k1 and k1 <= k2 and k2 < k3);
+		}
+	};
+
+	// Piecewise linear payoff with n sorted breakpoints k_i > 0, slope b_0 on [0, k_0),
+	// b_{i+1} on (k_i, k_{i+1}), and jump j_i at k_i. As a static replication
+	// g(x) = g(0) + b_0 x + sum_i (b_{i+1} - b_i) (x - k_i)^+ + j_i 1(x > k_i).
+	template<class K = double>
+		requires std::is_floating_point_v<K>
+	struct piecewise_linear {
+		typedef K type;
+		K level; // g(0)
+		std::vector<K> strike;
+		std::vector<K> slope; // n + 1 slopes
+		std::vector<K> jump;
+
+		piecewise_linear(K level, size_t n, const K* k, const K* b, const K* j = nullptr)
+			: level(level), strike(k, k + n), slope(b, b + n + 1), jump(n)
+		{
+			ensure(std::is_sorted(strike.begin(), strike.end()));
+			ensure(n == 0 or strike.front() > 0);
+			if (j) {
+				std::copy(j, j + n, jump.begin());
+			}
+		}
+
+		size_t size() const noexcept
+		{
+			return strike.size();
+		}
+
+		K operator()(K x) const noexcept
+		{
+			K g = level + slope[0] * x;
+
+			for (size_t i = 0; i < strike.size() and strike[i] < x; ++i) {
+				g += (slope[i + 1] - slope[i]) * (x - strike[i]) + jump[i];
+			}
+
+			return g;
+		}
 	};
 
 }
@@ -0,0 +1,286 @@
+// fms_pool.h - price batches in a pool of worker processes
+// Records are copied into shared memory and split into jobs of at most price::block.
+// Jobs and completions pass through a pair of rings per worker so no message is a
+// system call. Each worker is forked with its own copy of the model and can be pinned
+// to a core. Exceptions are caught per job. A worker that dies is replaced and the jobs
+// it never started go back on the queue. The job it was running is retried one record
+// at a time, so a record that kills its worker again is the only one set to NaN.
+// POSIX only.
+#pragma once
+#ifndef _WIN32
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <new>
+#include <thread>
+#include <vector>
+#include <sched.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "fms_ensure.h"
+#include "fms_mmap.h"
+#include "fms_price.h"
+#include "fms_ring.h"
+
+namespace fms {
+
+	template<class M>
+	class pool {
+		struct job {
+			uint64_t offset; // into shared records and results
+			uint64_t n;
+			price::measure w;
+		};
+		struct done {
+			uint64_t offset;
+			int32_t status; // 0 if the job did not throw
+		};
+		struct channel {
+			ring<job, 64> jobs;
+			ring<done, 64> finished;
+			std::atomic<uint32_t> stop;
+		};
+		static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+		M m;
+		size_t capacity; // records in shared memory
+		bool pin;
+		memory_map shm;
+		channel* c; // one per worker
+		price::record* in;
+		double* out;
+		std::vector<pid_t> pid;
+		std::vector<std::deque<job>> pending; // jobs sent to each worker
+		uint64_t restarts_, failed_;
+		std::deque<job> queue; // jobs not yet sent to a worker
+
+		static void backoff(unsigned& idle)
+		{
+			if (++idle < 64) {
+				std::this_thread::yield();
+			}
+			else {
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+		}
+
+		void serve(channel& ci, pid_t parent) const noexcept
+		{
+			option o(m);
+			job j;
+			unsigned idle = 0;
+
+			while (!ci.stop.load(std::memory_order_acquire)) {
+				if (!ci.jobs.pop(j)) {
+					// exit with the parent
+					if (idle > 64 and ::getppid() != parent) {
+						break;
+					}
+					backoff(idle);
+					continue;
+				}
+				idle = 0;
+
+				int32_t status = 0;
+				try {
+					price::price(o, j.w, j.n, in + j.offset, out + j.offset);
+				}
+				catch (...) {
+					// price records one at a time so only bad ones are NaN
+					status = 1;
+					for (uint64_t i = j.offset; i < j.offset + j.n; ++i) {
+						out[i] = price::price(o, j.w, in[i]);
+					}
+				}
+				while (!ci.finished.push(done{ j.offset, status })) {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		void spawn(size_t i)
+		{
+			c[i].~channel();
+			new (c + i) channel{};
+			pending[i].clear();
+
+			pid_t parent = ::getpid();
+			pid_t p = ::fork();
+			ensure(p != -1);
+			if (p == 0) {
+#ifdef __linux__
+				if (pin) {
+					unsigned cores = (std::max)(1u, std::thread::hardware_concurrency());
+					cpu_set_t cpu;
+					CPU_ZERO(&cpu);
+					CPU_SET(i % cores, &cpu);
+					::sched_setaffinity(0, sizeof(cpu), &cpu);
+				}
+#endif
+				serve(c[i], parent);
+				::_exit(0);
+			}
+			pid[i] = p;
+		}
+
+		// Replace worker i if it has exited and requeue its unfinished jobs.
+		bool reap(size_t i)
+		{
+			int status;
+			if (::waitpid(pid[i], &status, WNOHANG) != pid[i]) {
+				return false;
+			}
+
+			// completions pushed before the worker died are still good
+			done d;
+			while (c[i].finished.pop(d)) {
+				pending[i].pop_front();
+			}
+			if (!pending[i].empty()) {
+				// jobs run in order so only the first could have been running
+				job j = pending[i].front();
+				pending[i].pop_front();
+				if (j.n == 1) {
+					out[j.offset] = std::numeric_limits<double>::quiet_NaN();
+					++failed_;
+				}
+				else {
+					for (uint64_t l = 0; l < j.n; ++l) {
+						queue.push_back(job{ j.offset + l, 1, j.w });
+					}
+				}
+				queue.insert(queue.end(), pending[i].begin(), pending[i].end());
+			}
+			++restarts_;
+			spawn(i);
+
+			return true;
+		}
+	public:
+		// workers processes, or one per core if 0, sharing capacity records at a time.
+		pool(M m, unsigned workers = 0, size_t capacity = 16 * price::block, bool pin = false)
+			: m(std::move(m)), capacity(capacity), pin(pin), c(nullptr), in(nullptr), out(nullptr),
+			restarts_(0), failed_(0)
+		{
+			if (workers == 0) {
+				workers = (std::max)(1u, std::thread::hardware_concurrency());
+			}
+			ensure(capacity > 0);
+
+			size_t nc = (workers * sizeof(channel) + 63) / 64 * 64;
+			shm = memory_map::shared(nc + capacity * (sizeof(price::record) + sizeof(double)));
+			c = static_cast<channel*>(shm.data());
+			in = reinterpret_cast<price::record*>(static_cast<char*>(shm.data()) + nc);
+			out = reinterpret_cast<double*>(in + capacity);
+
+			for (size_t i = 0; i < workers; ++i) {
+				new (c + i) channel{};
+			}
+			pid.resize(workers, -1);
+			pending.resize(workers);
+			for (size_t i = 0; i < workers; ++i) {
+				spawn(i);
+			}
+		}
+		pool(const pool&) = delete;
+		pool& operator=(const pool&) = delete;
+		~pool()
+		{
+			for (size_t i = 0; i < pid.size(); ++i) {
+				c[i].stop.store(1, std::memory_order_release);
+			}
+			for (size_t i = 0; i < pid.size(); ++i) {
+				if (pid[i] > 0) {
+					::waitpid(pid[i], nullptr, 0);
+				}
+			}
+		}
+
+		size_t workers() const noexcept
+		{
+			return pid.size();
+		}
+		// process id of worker i
+		pid_t process(size_t i) const
+		{
+			return pid[i];
+		}
+		// workers replaced after dying
+		uint64_t restarts() const noexcept
+		{
+			return restarts_;
+		}
+		// records set to NaN because they killed their worker
+		uint64_t failed() const noexcept
+		{
+			return failed_;
+		}
+
+		// Write the measure of n records to out like price::price. Records that fail are NaN.
+		void price(price::measure w, size_t n, const price::record* r, double* v)
+		{
+			size_t k = pid.size();
+
+			for (size_t i0 = 0; i0 < n; i0 += capacity) {
+				size_t m_ = (std::min)(capacity, n - i0);
+				std::memcpy(in, r + i0, m_ * sizeof(price::record));
+
+				// enough jobs to keep every worker busy
+				size_t size = (std::min)(price::block, (m_ + k - 1) / k);
+				queue.clear();
+				for (size_t next = 0; next < m_; next += size) {
+					queue.push_back(job{ next, (std::min)(size, m_ - next), w });
+				}
+				// replace workers that died while idle before sending them jobs
+				for (size_t i = 0; i < k; ++i) {
+					reap(i);
+				}
+
+				size_t busy = 0;
+				unsigned idle = 0;
+				while (!queue.empty() or busy > 0) {
+					bool progress = false;
+					for (size_t i = 0; i < k; ++i) {
+						done d;
+						while (c[i].finished.pop(d)) {
+							pending[i].pop_front();
+							--busy;
+							progress = true;
+						}
+						if (!queue.empty() and c[i].jobs.push(queue.front())) {
+							pending[i].push_back(queue.front());
+							queue.pop_front();
+							++busy;
+							progress = true;
+						}
+					}
+					if (!progress) {
+						for (size_t i = 0; i < k; ++i) {
+							if (!pending[i].empty()) {
+								// jobs sent to a dead worker are back on the queue
+								size_t sent = pending[i].size();
+								if (reap(i)) {
+									busy -= sent;
+								}
+							}
+						}
+						backoff(idle);
+					}
+					else {
+						idle = 0;
+					}
+				}
+
+				std::memcpy(v + i0, out, m_ * sizeof(double));
+			}
+		}
+	};
+
+}
+#endif // _WIN32
@@ -0,0 +1,115 @@
+// fms_pool.t.cpp - test pricing in worker processes
+#ifndef _WIN32
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include <signal.h>
+#include <unistd.h>
+#include "fms_pool.h"
+#include "fms_variate_normal.h"
+
+using namespace fms;
+
+// normal model whose worker dies at one vol
+struct normal_crash : variate::normal_impl<> {
+	double cumulant(double s, size_t n = 0) const noexcept
+	{
+		if (s == 0.777) {
+			::_exit(3);
+		}
+
+		return variate::normal_impl<>::cumulant(s, n);
+	}
+};
+
+int test_pool()
+{
+	using price::kind;
+	using price::measure;
+
+	std::vector<price::record> r;
+	for (size_t i = 0; i < 10000; ++i) {
+		double k = 50 + (i % 101);
+		r.push_back({ 100, 0.1 + 0.01 * (i % 7), k < 100 ? -k : k, i % 13 ? kind::vanilla : kind::digital_call, 0 });
+	}
+	r[1234].f = -1; // fails
+	size_t n = r.size();
+	std::vector<double> v(n), v_(n);
+
+	{
+		variate::normal_impl<> N;
+		option o(N);
+		pool<variate::normal_impl<>> p(N, 3, 4096);
+		assert(p.workers() == 3);
+
+		for (measure w : { measure::value, measure::delta, measure::vega }) {
+			p.price(w, n, r.data(), v.data());
+			price::price(o, w, n, r.data(), v_.data());
+			for (size_t i = 0; i < n; ++i) {
+				assert(v[i] == v_[i] or (std::isnan(v[i]) and std::isnan(v_[i])));
+			}
+			assert(std::isnan(v[1234]));
+		}
+
+		// implied vols in place
+		std::vector<price::record> q(r.begin(), r.begin() + 1000);
+		price::price(o, measure::value, q.size(), q.data(), v.data());
+		for (size_t i = 0; i < q.size(); ++i) {
+			q[i].s = v[i];
+		}
+		// chains split across workers start from different guesses
+		p.price(measure::implied, q.size(), q.data(), v.data());
+		price::price(o, measure::implied, q.size(), q.data(), v_.data());
+		for (size_t i = 0; i < q.size(); ++i) {
+			assert(fabs(v[i] - v_[i]) < 1e-8 or (std::isnan(v[i]) and std::isnan(v_[i])));
+		}
+		assert(fabs(v[100] - r[100].s) < 1e-8);
+		assert(p.restarts() == 0);
+	}
+	{
+		// a worker that dies while idle is replaced before it is sent jobs or its jobs are requeued
+		variate::normal_impl<> N;
+		option o(N);
+		pool<variate::normal_impl<>> p(N, 2, 1024);
+		std::vector<price::record> q(r.begin() + 2000, r.begin() + 6000);
+		::kill(p.process(0), SIGKILL);
+		p.price(measure::value, q.size(), q.data(), v.data());
+		price::price(o, measure::value, q.size(), q.data(), v_.data());
+		for (size_t i = 0; i < q.size(); ++i) {
+			assert(v[i] == v_[i] or (std::isnan(v[i]) and std::isnan(v_[i])));
+		}
+		assert(p.restarts() == 1 and p.failed() == 0);
+	}
+	{
+		// a record that kills its worker is the only one lost
+		normal_crash N;
+		option o(N);
+		pool<normal_crash> p(N, 2, 1024);
+		std::vector<price::record> q(r.begin(), r.begin() + 2000);
+		q[1500].s = 0.777;
+		p.price(measure::value, q.size(), q.data(), v.data());
+		// once for the job and once for the record on its own
+		assert(p.restarts() == 2 and p.failed() == 1);
+		for (size_t i = 0; i < q.size(); ++i) {
+			if (i == 1500) {
+				assert(std::isnan(v[i]));
+			}
+			else {
+				double v_i = price::price(o, measure::value, q[i]);
+				assert(fabs(v[i] - v_i) < 1e-13 or (std::isnan(v[i]) and std::isnan(v_i)));
+			}
+		}
+
+		// the replacement worker prices the rest
+		q[1500].s = 0.2;
+		p.price(measure::value, q.size(), q.data(), v.data());
+		price::price(o, measure::value, q.size(), q.data(), v_.data());
+		for (size_t i = 0; i < q.size(); ++i) {
+			assert(fabs(v[i] - v_[i]) < 1e-13 or (std::isnan(v[i]) and std::isnan(v_[i])));
+		}
+	}
+
+	return 0;
+}
+int test_pool_ = test_pool();
+#endif // _WIN32
@@ -0,0 +1,66 @@
+// fms_price.cpp - value a binary file of quote records
+// usage: fms_price value|delta|gamma|vega|implied in out
+// in is a file of fms::price::record and out is created with one double per record.
+// Both are memory mapped and processed in batches of price::block records.
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "fms_mmap.h"
+#include "fms_price.h"
+#include "fms_variate_normal.h"
+
+using namespace fms;
+
+int main(int ac, const char* av[])
+{
+	static const char* measures[] = { "value", "delta", "gamma", "vega", "implied" };
+
+	if (ac != 4) {
+		fprintf(stderr, "usage: %s value|delta|gamma|vega|implied in out\n", av[0]);
+
+		return 1;
+	}
+
+	int w = 0;
+	while (w < 5 and strcmp(av[1], measures[w]) != 0) {
+		++w;
+	}
+	if (w == 5) {
+		fprintf(stderr, "unknown measure: %s\n", av[1]);
+
+		return 1;
+	}
+
+	try {
+		auto t0 = std::chrono::steady_clock::now();
+
+		memory_map in(av[2]);
+		ensure(in.size() % sizeof(price::record) == 0);
+		size_t n = in.count<price::record>();
+		if (n == 0) {
+			fprintf(stderr, "no records in %s\n", av[2]);
+
+			return 1;
+		}
+		memory_map out(av[3], n * sizeof(double));
+
+		variate::normal_impl<> N;
+		option o(N);
+		const price::record* r = in.as<price::record>();
+		double* v = out.as<double>();
+		for (size_t i = 0; i < n; i += price::block) {
+			size_t m = n - i < price::block ? n - i : price::block;
+			price::price(o, static_cast<price::measure>(w), m, r + i, v + i);
+		}
+
+		std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+		fprintf(stderr, "%zu records in %g seconds\n", n, dt.count());
+	}
+	catch (const std::exception& ex) {
+		fprintf(stderr, "%s\n", ex.what());
+
+		return 1;
+	}
+
+	return 0;
+}
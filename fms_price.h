@@ -0,0 +1,155 @@
+// fms_price.h - batch valuation of binary quote records
+// Records are fixed size so files can be mapped and processed in place. Runs of
+// consecutive vanilla records with the same forward and vol are valued as strips
+// and runs with the same forward are inverted as chains with warm starts, so
+// sorting files by forward, vol and strike makes batches cheaper.
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "fms_option.h"
+
+namespace fms::price {
+
+	enum class kind : int32_t {
+		vanilla = 0, // put if strike is negative
+		digital_call = 1,
+		digital_put = 2,
+	};
+
+	enum class measure {
+		value,
+		delta,
+		gamma,
+		vega,
+		implied, // s is the option value
+	};
+
+	struct record {
+		double f; // forward
+		double s; // vol, or value for implied
+		double k; // strike
+		kind p;
+		int32_t id; // not used
+	};
+	static_assert(sizeof(record) == 32);
+
+	// records per batch so scratch arrays stay in L2
+	inline constexpr size_t block = 4096;
+
+	// value, greek, or implied vol of one option with strike or payoff p
+	template<class M, class P>
+	inline double price(const option<M>& o, measure w, double f, double s, const P& p)
+	{
+		switch (w) {
+		case measure::value:
+			return o.value(f, s, p);
+		case measure::delta:
+			return o.delta(f, s, p);
+		case measure::gamma:
+			return o.gamma(f, s, p);
+		case measure::vega:
+			// vanilla vega needs edf
+			if constexpr (std::is_arithmetic_v<P> and !requires (const M& m, double x) { m.edf(x, x); }) {
+				break;
+			}
+			else {
+				return o.vega(f, s, p);
+			}
+		case measure::implied:
+			{
+				double s_ = 0;
+				o.implied(f, 1, &p, &s, &s_);
+
+				return s_;
+			}
+		}
+
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+
+	// NaN if the record fails
+	template<class M>
+	inline double price(const option<M>& o, measure w, const record& r)
+	{
+		try {
+			switch (r.p) {
+			case kind::vanilla:
+				return price(o, w, r.f, r.s, r.k);
+			case kind::digital_call:
+				return price(o, w, r.f, r.s, payoff::digital_call<double>(r.k));
+			case kind::digital_put:
+				return price(o, w, r.f, r.s, payoff::digital_put<double>(r.k));
+			}
+		}
+		catch (const std::exception&) {
+		}
+
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+
+	// Write the measure of n records to out in batches.
+	template<class M>
+	inline void price(const option<M>& o, measure w, size_t n, const record* r, double* out)
+	{
+		instrument::timer t_(instrument::batch);
+		std::vector<double> k, v, s;
+		k.reserve(block);
+		v.reserve(block);
+		s.reserve(block);
+
+		constexpr bool edf = requires (const M& m, double x) { m.edf(x, x); };
+
+		for (size_t i = 0; i < n; ) {
+			bool strip = r[i].p == kind::vanilla and (w == measure::value or w == measure::gamma or w == measure::implied
+				or (edf and w == measure::vega));
+			size_t j = i + 1;
+			if (strip) {
+				while (j < n and j - i < block and r[j].p == kind::vanilla and r[j].f == r[i].f
+					and (w == measure::implied or r[j].s == r[i].s)) {
+					++j;
+				}
+			}
+			if (j - i == 1) {
+				out[i] = price(o, w, r[i]);
+				++i;
+				continue;
+			}
+
+			size_t m = j - i;
+			k.resize(m);
+			v.resize(m);
+			for (size_t l = 0; l < m; ++l) {
+				k[l] = r[i + l].k;
+				v[l] = r[i + l].s;
+			}
+			try {
+				if (w == measure::implied) {
+					s.assign(m, 0.);
+					o.implied(r[i].f, m, k.data(), v.data(), s.data());
+					std::copy(s.begin(), s.end(), out + i);
+				}
+				else if (w == measure::value) {
+					o.value(r[i].f, r[i].s, m, k.data(), out + i);
+				}
+				else if (w == measure::gamma) {
+					o.gamma(r[i].f, r[i].s, m, k.data(), out + i);
+				}
+				else if constexpr (edf) {
+					o.vega(r[i].f, r[i].s, m, k.data(), out + i);
+				}
+			}
+			catch (const std::exception&) {
+				// value records one at a time to isolate the failure
+				for (size_t l = i; l < j; ++l) {
+					out[l] = price(o, w, r[l]);
+				}
+			}
+			i = j;
+		}
+	}
+
+}
@@ -0,0 +1,93 @@
+// fms_price.t.cpp - test batch valuation of mapped records
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "fms_mmap.h"
+#include "fms_price.h"
+#include "fms_variate_discrete.h"
+#include "fms_variate_normal.h"
+
+using namespace fms;
+
+int test_mmap()
+{
+	const char* file = "fms_mmap.t.bin";
+	{
+		memory_map m(file, 3 * sizeof(double));
+		assert(m.size() == 3 * sizeof(double));
+		double* d = m.as<double>();
+		d[0] = 1;
+		d[1] = 2;
+		d[2] = 3;
+	}
+	{
+		memory_map m(file);
+		assert(m.count<double>() == 3);
+		assert(m.as<double>()[2] == 3);
+
+		memory_map m_(std::move(m));
+		assert(m.size() == 0 and m.data() == nullptr);
+		assert(m_.as<double>()[1] == 2);
+	}
+	std::remove(file);
+
+	return 0;
+}
+int test_mmap_ = test_mmap();
+
+int test_price()
+{
+	variate::normal_impl<> N;
+	option o(N);
+	using price::kind;
+	using price::measure;
+
+	std::vector<price::record> r;
+	for (double f : { 100., 110. }) {
+		for (double k : { -90., -95., 100., 105., 110. }) {
+			r.push_back({ f, 0.2, k, kind::vanilla, 0 });
+		}
+		r.push_back({ f, 0.3, 100., kind::vanilla, 0 });
+		r.push_back({ f, 0.2, 100., kind::digital_call, 0 });
+		r.push_back({ f, 0.2, 100., kind::digital_put, 0 });
+	}
+	r.push_back({ 100, 0.2, 0., kind::vanilla, 0 }); // zero strike
+	r.push_back({ -1, 0.2, 100., kind::vanilla, 0 }); // fails
+
+	size_t n = r.size();
+	std::vector<double> v(n);
+	for (measure w : { measure::value, measure::delta, measure::gamma, measure::vega }) {
+		price::price(o, w, n, r.data(), v.data());
+		for (size_t i = 0; i + 1 < n; ++i) {
+			assert(fabs(v[i] - price::price(o, w, r[i])) < 1e-14);
+		}
+		assert(v[n - 1] != v[n - 1]);
+	}
+	{
+		// vega strips for a model with edf
+		variate::discrete<> D({ -1, 0, 2 }, { 0.25, 0.5, 0.25 });
+		option o_(D);
+		price::price(o_, measure::vega, n, r.data(), v.data());
+		for (size_t i = 0; i + 1 < n; ++i) {
+			assert(fabs(v[i] - price::price(o_, measure::vega, r[i])) < 1e-14);
+		}
+		assert(v[n - 1] != v[n - 1]);
+		assert(v[2] > 0 and v[2] == v[1]); // put and call vega
+	}
+	{
+		// implied vol from values
+		std::vector<price::record> r_(r.begin(), r.end() - 2);
+		price::price(o, measure::value, r_.size(), r_.data(), v.data());
+		for (size_t i = 0; i < r_.size(); ++i) {
+			r_[i].s = v[i];
+		}
+		price::price(o, measure::implied, r_.size(), r_.data(), v.data());
+		for (size_t i = 0; i < r_.size(); ++i) {
+			assert(fabs(v[i] - r[i].s) < 1e-8);
+		}
+	}
+
+	return 0;
+}
+int test_price_ = test_price();
@@ -0,0 +1,72 @@
+// fms_ring.h - single producer single consumer ring buffer
+// The ring is a standard layout struct with no pointers so it can be placed in memory
+// shared between processes. Head and tail are lock free atomics on their own cache lines.
+// The producer publishes an item with a release store of head and the consumer frees a
+// slot with a release store of tail, so writes made before a push, such as results in
+// other shared memory, are visible to the consumer after the matching pop.
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace fms {
+
+	// N must be a power of 2.
+	template<class T, size_t N>
+	struct ring {
+		static_assert(N > 0 and (N & (N - 1)) == 0);
+		static_assert(std::is_trivially_copyable_v<T>);
+		static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+		alignas(64) std::atomic<uint64_t> head; // next slot to write
+		alignas(64) std::atomic<uint64_t> tail; // next slot to read
+		alignas(64) T item[N];
+
+		ring() noexcept
+			: head(0), tail(0)
+		{ }
+		ring(const ring&) = delete;
+		ring& operator=(const ring&) = delete;
+
+		static constexpr size_t capacity() noexcept
+		{
+			return N;
+		}
+		// items in the ring, exact when called by the producer or consumer
+		size_t size() const noexcept
+		{
+			return static_cast<size_t>(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire));
+		}
+		bool empty() const noexcept
+		{
+			return size() == 0;
+		}
+
+		// Producer only. False if full.
+		bool push(const T& t) noexcept
+		{
+			uint64_t h = head.load(std::memory_order_relaxed);
+			if (h - tail.load(std::memory_order_acquire) == N) {
+				return false;
+			}
+			item[h & (N - 1)] = t;
+			head.store(h + 1, std::memory_order_release);
+
+			return true;
+		}
+		// Consumer only. False if empty.
+		bool pop(T& t) noexcept
+		{
+			uint64_t r = tail.load(std::memory_order_relaxed);
+			if (head.load(std::memory_order_acquire) == r) {
+				return false;
+			}
+			t = item[r & (N - 1)];
+			tail.store(r + 1, std::memory_order_release);
+
+			return true;
+		}
+	};
+
+}
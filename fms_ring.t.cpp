@@ -0,0 +1,60 @@
+// fms_ring.t.cpp - test single producer single consumer ring
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include "fms_ring.h"
+
+using namespace fms;
+
+int test_ring()
+{
+	{
+		ring<int, 4> r;
+		int i;
+		assert(r.empty() and !r.pop(i));
+		for (int j = 0; j < 4; ++j) {
+			assert(r.push(j));
+		}
+		assert(!r.push(4));
+		assert(r.size() == 4);
+		assert(r.pop(i) and i == 0);
+		assert(r.push(4));
+		for (int j = 1; j <= 4; ++j) {
+			assert(r.pop(i) and i == j);
+		}
+		assert(r.empty());
+	}
+	{
+		// items arrive in order across threads
+		auto r = std::make_unique<ring<uint64_t, 64>>();
+		constexpr uint64_t n = 100000;
+		std::thread producer([&r] {
+			for (uint64_t i = 0; i < n; ) {
+				if (r->push(i)) {
+					++i;
+				}
+				else {
+					std::this_thread::yield();
+				}
+			}
+		});
+		uint64_t next = 0;
+		bool ok = true;
+		while (next < n) {
+			uint64_t i;
+			if (r->pop(i)) {
+				ok = ok and i == next;
+				++next;
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+		producer.join();
+		assert(ok and r->empty());
+	}
+
+	return 0;
+}
+int test_ring_ = test_ring();
@@ -0,0 +1,355 @@
+// fms_service.h - pricing service shared by processes over named shared memory
+// A server maps a named segment with one slot per client process. Each slot has a ring
+// of requests and a ring of replies so sending a request or reading a reply is never a
+// system call. One server thread polls the slots and feeds a batcher, so requests from
+// every client are coalesced into strips and chains priced with one warm model that a
+// calibrator can replace with publish. Replies carry the model version and the latency
+// from the time the client sent the request. A client that stops reading replies only
+// stalls its own requests. steady_clock is CLOCK_MONOTONIC on POSIX
+// so times are comparable across processes. A slot is reclaimed when its client closes
+// or dies and a segment left by a server that died is replaced.
+// POSIX only.
+#pragma once
+#ifndef _WIN32
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <signal.h>
+#include <unistd.h>
+#include "fms_batcher.h"
+#include "fms_ensure.h"
+#include "fms_mmap.h"
+#include "fms_ring.h"
+
+namespace fms::service {
+
+	inline constexpr char magic[8] = { 'f', 'm', 's', 's', 'v', 'c', '1', 0 };
+	inline constexpr size_t depth = 1024; // requests or replies in flight per client
+
+	struct message {
+		price::record r;
+		price::measure w;
+		uint64_t id; // chosen by the client
+		int64_t t; // steady_clock nanoseconds when sent
+	};
+	struct reply {
+		uint64_t id;
+		double value; // NaN if the request failed
+		uint64_t version; // of the model used
+		int64_t latency; // nanoseconds from send to priced
+	};
+
+	enum state : uint32_t {
+		closed,
+		claimed, // by a client setting its pid
+		open, // waiting for the server to reset the rings
+		ready,
+		closing, // waiting for outstanding replies
+	};
+
+	struct slot {
+		std::atomic<uint32_t> state;
+		std::atomic<int32_t> pid; // of the client
+		ring<message, depth> in;
+		ring<reply, depth> out;
+	};
+	struct header {
+		char magic[8];
+		uint32_t slots;
+		std::atomic<int32_t> pid; // of the server, 0 when stopped
+	};
+	static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+	inline int64_t now() noexcept
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+	inline bool alive(int32_t pid) noexcept
+	{
+		return pid > 0 and (::kill(pid, 0) == 0 or errno != ESRCH);
+	}
+	inline void backoff(unsigned& idle)
+	{
+		if (++idle < 64) {
+			std::this_thread::yield();
+		}
+		else {
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+	}
+	// slots follow the header
+	inline constexpr size_t offset = (sizeof(header) + alignof(slot) - 1) / alignof(slot) * alignof(slot);
+	inline slot* slots(header* h) noexcept
+	{
+		return reinterpret_cast<slot*>(reinterpret_cast<char*>(h) + offset);
+	}
+
+	template<class M>
+	class server {
+		std::string name;
+		memory_map shm;
+		header* h;
+		slot* s;
+		std::unique_ptr<std::atomic<uint64_t>[]> outstanding; // requests in the batcher per slot
+		std::unique_ptr<batcher<M>> b;
+		std::atomic<bool> stop;
+		std::thread poller;
+
+		static memory_map create(const char* name, size_t size)
+		{
+			// replace a segment left by a server that died
+			try {
+				memory_map m = memory_map::shared(name, 0);
+				if (m.size() < sizeof(header) or !alive(m.as<header>()->pid.load())) {
+					memory_map::unlink(name);
+				}
+			}
+			catch (const std::exception&) {
+			}
+
+			return memory_map::shared(name, size);
+		}
+
+		// push a reply unless the client has gone, poll leaves room for it
+		void complete(uint32_t i, const reply& y)
+		{
+			slot& s_ = s[i];
+			for (unsigned spin = 1; s_.state.load(std::memory_order_acquire) == ready and !s_.out.push(y); ++spin) {
+				if (spin % 1024 == 0 and !alive(s_.pid.load())) {
+					break;
+				}
+				std::this_thread::yield();
+			}
+			outstanding[i].fetch_sub(1, std::memory_order_release);
+		}
+
+		void poll()
+		{
+			unsigned idle = 0;
+			uint64_t loops = 0;
+			message q;
+
+			while (!stop.load(std::memory_order_acquire)) {
+				bool progress = false;
+				bool sweep = ++loops % 4096 == 0 or idle == 64;
+				for (uint32_t i = 0; i < h->slots; ++i) {
+					slot& s_ = s[i];
+					switch (s_.state.load(std::memory_order_acquire)) {
+					case open:
+						s_.in.~ring();
+						new (&s_.in) ring<message, depth>{};
+						s_.out.~ring();
+						new (&s_.out) ring<reply, depth>{};
+						s_.state.store(ready, std::memory_order_release);
+						progress = true;
+						break;
+					case ready:
+						// Leave room in the reply ring for every outstanding request so complete
+						// never waits on a client that is not reading. Reading outstanding first
+						// can only overcount since a reply is pushed before it is decremented.
+						for (size_t j = 0; j < depth; ++j) {
+							if (outstanding[i].load(std::memory_order_acquire) + s_.out.size() >= depth or !s_.in.pop(q)) {
+								break;
+							}
+							outstanding[i].fetch_add(1, std::memory_order_relaxed);
+							uint64_t id = q.id;
+							try {
+								b->submit(q.r, q.w, [this, i, id](const typename batcher<M>::result& r) {
+									complete(i, reply{ id, r.value, r.version, r.latency.count() });
+								}, typename batcher<M>::clock::time_point(std::chrono::nanoseconds(q.t)));
+							}
+							catch (const std::exception&) {
+								complete(i, reply{ id, std::numeric_limits<double>::quiet_NaN(), 0, 0 });
+							}
+							progress = true;
+						}
+						if (sweep and !alive(s_.pid.load())) {
+							s_.state.store(closing, std::memory_order_release);
+						}
+						break;
+					case closing:
+						if (outstanding[i].load(std::memory_order_acquire) == 0) {
+							s_.pid.store(0);
+							s_.state.store(closed, std::memory_order_release);
+							progress = true;
+						}
+						break;
+					case claimed:
+						// client died before opening
+						if (sweep and s_.pid.load() != 0 and !alive(s_.pid.load())) {
+							s_.pid.store(0);
+							s_.state.store(closed, std::memory_order_release);
+						}
+						break;
+					}
+				}
+				if (progress) {
+					idle = 0;
+				}
+				else {
+					backoff(idle);
+				}
+			}
+		}
+	public:
+		// Serve model m under name, e.g. "/fms_price", to at most slots client processes.
+		// Batches have at most max requests and wait up to linger to fill.
+		server(const char* name, M m, uint32_t slots = 16, size_t max = price::block,
+			std::chrono::microseconds linger = std::chrono::microseconds(50))
+			: name(name), h(nullptr), s(nullptr), stop(false)
+		{
+			ensure(slots > 0);
+
+			shm = create(name, offset + slots * sizeof(slot));
+			h = shm.as<header>();
+			s = service::slots(h);
+			for (uint32_t i = 0; i < slots; ++i) {
+				new (s + i) slot{};
+			}
+			outstanding = std::make_unique<std::atomic<uint64_t>[]>(slots);
+			b = std::make_unique<batcher<M>>(std::move(m), max, linger);
+			h->slots = slots;
+			h->pid.store(::getpid());
+			std::memcpy(h->magic, magic, sizeof(magic));
+			std::atomic_thread_fence(std::memory_order_release);
+
+			poller = std::thread([this] { poll(); });
+		}
+		server(const server&) = delete;
+		server& operator=(const server&) = delete;
+		// Requests already received are answered before returning.
+		~server()
+		{
+			stop.store(true, std::memory_order_release);
+			poller.join();
+			b.reset();
+			h->pid.store(0);
+			memory_map::unlink(name.c_str());
+		}
+
+		// Replace the model used by later batches.
+		uint64_t publish(M m)
+		{
+			return b->publish(std::move(m));
+		}
+		typename batcher<M>::stats statistics() const
+		{
+			return b->statistics();
+		}
+		// slots in use
+		size_t clients() const noexcept
+		{
+			size_t n = 0;
+			for (uint32_t i = 0; i < h->slots; ++i) {
+				n += s[i].state.load() != closed;
+			}
+
+			return n;
+		}
+	};
+
+	// One per process. Not thread safe, since each slot has a single producer and consumer.
+	class client {
+		memory_map shm;
+		header* h;
+		slot* s;
+		uint64_t next; // id for price
+	public:
+		// Connect to the server at name, waiting for it to open a slot.
+		explicit client(const char* name)
+			: shm(memory_map::shared(name, 0)), h(shm.as<header>()), s(nullptr), next(uint64_t(1) << 63)
+		{
+			std::atomic_thread_fence(std::memory_order_acquire);
+			ensure(shm.size() >= sizeof(header));
+			ensure(std::memcmp(h->magic, magic, sizeof(magic)) == 0);
+			ensure(connected());
+
+			slot* s_ = slots(h);
+			for (uint32_t i = 0; i < h->slots and !s; ++i) {
+				uint32_t f = closed;
+				if (s_[i].state.compare_exchange_strong(f, claimed)) {
+					s = s_ + i;
+				}
+			}
+			ensure(s || !"service: no free slot");
+			s->pid.store(::getpid());
+			s->state.store(open, std::memory_order_release);
+
+			unsigned idle = 0;
+			while (s->state.load(std::memory_order_acquire) != ready) {
+				ensure(connected() || !"service: server is gone");
+				backoff(idle);
+			}
+		}
+		client(const client&) = delete;
+		client& operator=(const client&) = delete;
+		~client()
+		{
+			s->state.store(closing, std::memory_order_release);
+		}
+
+		// True while the server is running.
+		bool connected() const noexcept
+		{
+			return alive(h->pid.load());
+		}
+
+		// Send a request with an id below 2^63. False if full, so receive replies and try again.
+		bool send(const price::record& r, price::measure w, uint64_t id) noexcept
+		{
+			return s->in.push(message{ r, w, id, now() });
+		}
+		// Next reply, in completion order, if any.
+		bool receive(reply& y) noexcept
+		{
+			return s->out.pop(y);
+		}
+
+		// Write the measure of n records to v, and the latency of each in nanoseconds if
+		// latency is not null, blocking until every reply arrives. Receive replies to
+		// requests made with send first since others are discarded.
+		void price(price::measure w, size_t n, const price::record* r, double* v, int64_t* latency = nullptr)
+		{
+			uint64_t base = next;
+			next += n;
+
+			size_t sent = 0, got = 0;
+			unsigned idle = 0;
+			while (got < n) {
+				bool progress = false;
+				while (sent < n and send(r[sent], w, base + sent)) {
+					++sent;
+					progress = true;
+				}
+				reply y;
+				while (receive(y)) {
+					if (y.id - base < n) {
+						v[y.id - base] = y.value;
+						if (latency) {
+							latency[y.id - base] = y.latency;
+						}
+						++got;
+					}
+					progress = true;
+				}
+				if (progress) {
+					idle = 0;
+				}
+				else {
+					ensure(connected() || !"service: server is gone");
+					backoff(idle);
+				}
+			}
+		}
+	};
+
+}
+#endif // _WIN32
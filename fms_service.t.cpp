@@ -0,0 +1,198 @@
+// fms_service.t.cpp - test pricing service shared by processes
+#ifndef _WIN32
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "fms_service.h"
+#include "fms_variate_discrete.h"
+
+using namespace fms;
+
+int test_service()
+{
+	using model = variate::discrete<double, double, 2>;
+	model m0({ -1, 1 }, { 0.5, 0.5 });
+	model m1({ -2, 0.5 }, { 0.2, 0.8 });
+	option o0(m0);
+	option o1(m1);
+	using price::kind;
+	using price::measure;
+
+	std::string name = "/fms_service_t" + std::to_string(::getpid());
+	std::vector<price::record> r;
+	for (size_t i = 0; i < 3000; ++i) {
+		double k = 80 + (i * 7) % 41;
+		r.push_back({ 100, 0.1 + 0.1 * (i % 3), k < 100 ? -k : k, i % 11 ? kind::vanilla : kind::digital_put, 0 });
+	}
+	size_t n = r.size();
+	std::vector<double> v(n);
+	std::vector<int64_t> t(n);
+	auto same = [](double a, double b) {
+		return a == b or fabs(a - b) < 1e-8 or (std::isnan(a) and std::isnan(b));
+	};
+
+	{
+		// a segment left by a server that died is replaced
+		memory_map::shared(name.c_str(), 4096);
+	}
+	{
+		service::server<model> srv(name.c_str(), m0, 4, 256);
+		{
+			service::client c(name.c_str());
+			assert(c.connected() and srv.clients() == 1);
+
+			c.price(measure::value, n, r.data(), v.data(), t.data());
+			for (size_t i = 0; i < n; ++i) {
+				assert(same(v[i], price::price(o0, measure::value, r[i])));
+				assert(t[i] >= 0);
+			}
+
+			// asynchronous requests complete in any order
+			for (uint64_t id = 0; id < 10; ++id) {
+				assert(c.send(r[id], measure::delta, id));
+			}
+			size_t got = 0;
+			service::reply y;
+			while (got < 10) {
+				if (c.receive(y)) {
+					assert(y.id < 10 and y.version == 1);
+					assert(same(y.value, price::price(o0, measure::delta, r[y.id])));
+					++got;
+				}
+				else {
+					std::this_thread::yield();
+				}
+			}
+
+			assert(srv.publish(m1) == 2);
+			c.price(measure::value, 1, r.data(), v.data());
+			assert(same(v[0], price::price(o1, measure::value, r[0])));
+			srv.publish(m0);
+		}
+
+		{
+			// a client that does not read replies does not stall the others
+			service::client a(name.c_str());
+			size_t sent = 0;
+			for (unsigned idle = 0; idle < 1000; ) {
+				if (a.send(r[sent % n], measure::value, sent)) {
+					++sent;
+					idle = 0;
+				}
+				else {
+					++idle;
+					std::this_thread::sleep_for(std::chrono::microseconds(10));
+				}
+			}
+			assert(sent > service::depth);
+
+			std::atomic<bool> done = false;
+			std::thread tb([&] {
+				service::client b(name.c_str());
+				std::vector<double> u(n);
+				b.price(measure::value, n, r.data(), u.data());
+				for (size_t i = 0; i < n; ++i) {
+					assert(same(u[i], price::price(o0, measure::value, r[i])));
+				}
+				done = true;
+			});
+			for (int i = 0; i < 10000 and !done; ++i) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			assert(done);
+			tb.join();
+
+			service::reply y;
+			for (size_t got = 0; got < sent; ) {
+				if (a.receive(y)) {
+					assert(y.id < sent and same(y.value, price::price(o0, measure::value, r[y.id % n])));
+					++got;
+				}
+				else {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		// client processes share the server
+		std::vector<pid_t> pid;
+		for (int j = 0; j < 3; ++j) {
+			pid_t p = ::fork();
+			assert(p != -1);
+			if (p == 0) {
+				int bad = 0;
+				try {
+					service::client c(name.c_str());
+					measure w = j == 2 ? measure::implied : measure::value;
+					std::vector<price::record> q(r);
+					if (w == measure::implied) {
+						for (size_t i = 0; i < n; ++i) {
+							q[i].s = price::price(o0, measure::value, r[i]);
+						}
+					}
+					std::vector<double> u(n);
+					c.price(w, n, q.data(), u.data());
+					for (size_t i = 0; i < n; ++i) {
+						if (w == measure::implied) {
+							// vols agree to the solver tolerance so compare repriced values
+							price::record p = q[i];
+							p.s = u[i];
+							double u_ = price::price(o0, w, q[i]);
+							bad += std::isnan(u_) ? !std::isnan(u[i]) : !(fabs(price::price(o0, measure::value, p) - q[i].s) < 1e-8);
+						}
+						else {
+							bad += !same(u[i], price::price(o0, w, q[i]));
+						}
+					}
+				}
+				catch (...) {
+					bad = 1;
+				}
+				::_exit(bad ? 1 : 0);
+			}
+			pid.push_back(p);
+		}
+		for (pid_t p : pid) {
+			int status;
+			assert(::waitpid(p, &status, 0) == p);
+			assert(WIFEXITED(status) and WEXITSTATUS(status) == 0);
+		}
+
+		// the slot of a client that dies without closing is reclaimed
+		pid_t p = ::fork();
+		if (p == 0) {
+			service::client c(name.c_str());
+			c.send(r[0], measure::value, 0);
+			::_exit(0);
+		}
+		::waitpid(p, nullptr, 0);
+		for (int i = 0; i < 2000 and srv.clients() > 0; ++i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		assert(srv.clients() == 0);
+
+		auto s = srv.statistics();
+		assert(s.requests >= 4 * n + 11);
+		assert(s.batches < s.requests);
+	}
+	{
+		// gone with the server
+		bool thrown = false;
+		try {
+			service::client c(name.c_str());
+		}
+		catch (const std::exception&) {
+			thrown = true;
+		}
+		assert(thrown);
+	}
+
+	return 0;
+}
+int test_service_ = test_service();
+#endif // _WIN32
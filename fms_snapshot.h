@@ -0,0 +1,271 @@
+// fms_snapshot.h - binary snapshot of calibrated models
+// A snapshot is a header, a table of entries sorted by id, and 64 byte aligned data blocks.
+// Readers map the file and use models in place: opening checks the header and table,
+// normal parameters are read directly, and discrete models are views of the mapped atoms.
+// Scalars are stored in native byte order and files with a different order are rejected.
+//
+// offset  contents
+// 0       header
+// 32      entry[count]
+// ...     data blocks, normal: mu sigma, discrete: x[n] padding p[n]
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_mmap.h"
+#include "fms_variate_discrete.h"
+#include "fms_variate_normal.h"
+
+namespace fms::snapshot {
+
+	inline constexpr char magic[8] = { 'f', 'm', 's', 's', 'n', 'a', 'p', 0 };
+	inline constexpr uint32_t version = 1;
+	inline constexpr uint32_t order = 0x01020304; // reads differently on the other byte order
+	inline constexpr size_t align = 64;
+
+	// New kinds of model are appended.
+	enum class kind : uint32_t {
+		normal = 1,
+		discrete = 2,
+	};
+
+	struct header {
+		char magic[8];
+		uint32_t version;
+		uint32_t order;
+		uint64_t count; // number of entries
+		uint64_t size; // file bytes
+	};
+	static_assert(sizeof(header) == 32);
+
+	struct entry {
+		uint64_t id;
+		kind type;
+		uint32_t scalar; // sizeof scalar type
+		uint64_t n; // number of parameters or atoms
+		uint64_t offset; // of data from start of snapshot
+	};
+	static_assert(sizeof(entry) == 32);
+
+	inline constexpr uint64_t pad(uint64_t n) noexcept
+	{
+		return (n + align - 1) / align * align;
+	}
+	// bytes of data for an entry
+	inline constexpr uint64_t bytes(kind type, uint64_t scalar, uint64_t n) noexcept
+	{
+		return type == kind::discrete ? pad(n * scalar) + n * scalar : n * scalar;
+	}
+
+	// Collect models then write them to a file.
+	class writer {
+		std::vector<entry> e;
+		std::vector<std::vector<unsigned char>> data;
+
+		template<class X>
+		void add(uint64_t id, kind type, size_t n, const X* x, const X* p = nullptr)
+		{
+			for (const auto& e_ : e) {
+				ensure(e_.id != id);
+			}
+
+			e.push_back(entry{ id, type, static_cast<uint32_t>(sizeof(X)), n, 0 });
+			data.emplace_back(bytes(type, sizeof(X), n));
+			unsigned char* d = data.back().data();
+			std::memcpy(d, x, n * sizeof(X));
+			if (p) {
+				std::memcpy(d + pad(n * sizeof(X)), p, n * sizeof(X));
+			}
+		}
+		template<class D>
+		void add_discrete(uint64_t id, const D& d)
+		{
+			using X = typename D::xtype;
+			size_t n = d.size();
+			std::vector<X> x(n), p(n);
+
+			for (size_t i = 0; i < n; ++i) {
+				x[i] = d.atom(i);
+				p[i] = d.probability(i);
+			}
+			add(id, kind::discrete, n, x.data(), p.data());
+		}
+	public:
+		template<class X, class S>
+		void add(uint64_t id, const variate::normal_impl<X, S>& m)
+		{
+			X x[2] = { m.mean(), m.stdev() };
+
+			add(id, kind::normal, 2, x);
+		}
+		template<class X, class S, size_t N>
+		void add(uint64_t id, const variate::discrete<X, S, N>& m)
+		{
+			add_discrete(id, m);
+		}
+		template<class X, class S>
+		void add(uint64_t id, const variate::discrete_view<X, S>& m)
+		{
+			add_discrete(id, m);
+		}
+
+		size_t size() const noexcept
+		{
+			return e.size();
+		}
+
+		// Bytes in the snapshot.
+		uint64_t layout()
+		{
+			std::vector<size_t> i(e.size());
+			for (size_t j = 0; j < i.size(); ++j) {
+				i[j] = j;
+			}
+			std::sort(i.begin(), i.end(), [this](size_t a, size_t b) { return e[a].id < e[b].id; });
+
+			std::vector<entry> e_(e.size());
+			std::vector<std::vector<unsigned char>> data_(e.size());
+			uint64_t off = pad(sizeof(header) + e.size() * sizeof(entry));
+			for (size_t j = 0; j < i.size(); ++j) {
+				e_[j] = e[i[j]];
+				e_[j].offset = off;
+				data_[j] = std::move(data[i[j]]);
+				off = pad(off + data_[j].size());
+			}
+			e = std::move(e_);
+			data = std::move(data_);
+
+			return off;
+		}
+
+		// Write the snapshot to buf of size layout().
+		void write(void* buf, uint64_t size) const
+		{
+			unsigned char* b = static_cast<unsigned char*>(buf);
+			std::memset(b, 0, size);
+
+			header h;
+			std::memcpy(h.magic, magic, sizeof(magic));
+			h.version = version;
+			h.order = order;
+			h.count = e.size();
+			h.size = size;
+			std::memcpy(b, &h, sizeof(h));
+			if (e.size()) {
+				std::memcpy(b + sizeof(h), e.data(), e.size() * sizeof(entry));
+			}
+			for (size_t j = 0; j < e.size(); ++j) {
+				ensure(e[j].offset + data[j].size() <= size);
+				std::memcpy(b + e[j].offset, data[j].data(), data[j].size());
+			}
+		}
+
+		// Create file containing the snapshot.
+		void write(const char* file)
+		{
+			uint64_t n = layout();
+			memory_map m(file, n);
+
+			write(m.data(), n);
+		}
+	};
+
+	// Models in a snapshot, read in place.
+	class reader {
+		memory_map m;
+		const unsigned char* b;
+		const entry* e;
+		uint64_t n;
+
+		void open(uint64_t size)
+		{
+			ensure(size >= sizeof(header));
+			ensure(reinterpret_cast<uintptr_t>(b) % alignof(entry) == 0);
+
+			const header* h = reinterpret_cast<const header*>(b);
+			ensure(std::memcmp(h->magic, magic, sizeof(magic)) == 0);
+			ensure(h->version == version);
+			ensure(h->order == order);
+			ensure(h->size == size);
+			ensure(h->count <= (size - sizeof(header)) / sizeof(entry));
+
+			n = h->count;
+			e = reinterpret_cast<const entry*>(b + sizeof(header));
+			for (uint64_t i = 0; i < n; ++i) {
+				ensure(i == 0 or e[i - 1].id < e[i].id);
+				ensure(e[i].offset % align == 0);
+				ensure(e[i].scalar == 4 or e[i].scalar == 8 or e[i].scalar == 16);
+				ensure(e[i].n <= size / e[i].scalar);
+				ensure(e[i].offset <= size and bytes(e[i].type, e[i].scalar, e[i].n) <= size - e[i].offset);
+			}
+		}
+		template<class X>
+		const X* data(size_t i, kind type) const
+		{
+			ensure(i < n);
+			ensure(e[i].type == type);
+			ensure(e[i].scalar == sizeof(X));
+
+			return reinterpret_cast<const X*>(b + e[i].offset);
+		}
+	public:
+		// Map file read only.
+		reader(const char* file)
+			: m(file), b(m.as<unsigned char>()), e(nullptr), n(0)
+		{
+			open(m.size());
+		}
+		// Snapshot of size bytes at buf, aligned to 64 bytes, that must outlive the reader.
+		reader(const void* buf, uint64_t size)
+			: b(static_cast<const unsigned char*>(buf)), e(nullptr), n(0)
+		{
+			open(size);
+		}
+		reader(const reader&) = delete;
+		reader& operator=(const reader&) = delete;
+		~reader() = default;
+
+		// number of models
+		size_t size() const noexcept
+		{
+			return n;
+		}
+		uint64_t id(size_t i) const
+		{
+			return e[i].id;
+		}
+		kind type(size_t i) const
+		{
+			return e[i].type;
+		}
+		// index of id or size() if not found
+		size_t find(uint64_t id) const noexcept
+		{
+			const entry* i = std::lower_bound(e, e + n, id, [](const entry& e_, uint64_t id_) { return e_.id < id_; });
+
+			return i != e + n and i->id == id ? i - e : n;
+		}
+
+		template<class X = double, class S = X>
+		variate::normal_impl<X, S> normal(size_t i) const
+		{
+			const X* x = data<X>(i, kind::normal);
+			ensure(e[i].n == 2);
+
+			return variate::normal_impl<X, S>(x[0], x[1]);
+		}
+		// Valid while the reader exists.
+		template<class X = double, class S = X>
+		variate::discrete_view<X, S> discrete(size_t i) const
+		{
+			const X* x = data<X>(i, kind::discrete);
+			size_t m_ = e[i].n;
+			ensure(m_ > 0);
+
+			return variate::discrete_view<X, S>(m_, x, x + pad(m_ * sizeof(X)) / sizeof(X));
+		}
+	};
+
+}
@@ -0,0 +1,113 @@
+// fms_snapshot.t.cpp - test binary model snapshots
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "fms_option.h"
+#include "fms_snapshot.h"
+
+using namespace fms;
+
+int test_snapshot()
+{
+	const char* file = "fms_snapshot.t.bin";
+	variate::normal_impl<> N(0.1, 2);
+	variate::discrete<> D({ -1, 0, 2 }, { 0.25, 0.5, 0.25 });
+	variate::discrete<double, double, 4> D4({ -2, 1 }, { 1. / 3, 2. / 3 });
+	variate::discrete<float, float, 0> Df({ -1, 1 }, { 0.5f, 0.5f });
+
+	{
+		snapshot::writer w;
+		w.add(30, D);
+		w.add(10, N);
+		w.add(20, D4);
+		w.add(40, Df);
+		try {
+			w.add(20, N);
+			assert(false);
+		}
+		catch (const std::exception&) {
+			assert(w.size() == 4);
+		}
+		w.write(file);
+	}
+	{
+		snapshot::reader r(file);
+		assert(r.size() == 4);
+		assert(r.id(0) == 10 and r.id(3) == 40);
+		assert(r.find(20) == 1);
+		assert(r.find(25) == r.size());
+		assert(r.type(r.find(30)) == snapshot::kind::discrete);
+
+		auto N_ = r.normal(r.find(10));
+		assert(N_.mean() == N.mean() and N_.stdev() == N.stdev());
+
+		auto D_ = r.discrete(r.find(30));
+		assert(D_.size() == 3);
+		for (size_t i = 0; i < D.size(); ++i) {
+			assert(D_.atom(i) == D.atom(i));
+			assert(D_.probability(i) == D.probability(i));
+		}
+		for (double x : { -1.5, -1., 0.5, 3. }) {
+			assert(D_.cdf(x, 0.3) == D.cdf(x, 0.3));
+		}
+		assert(D_.cumulant(0.3, 2) == D.cumulant(0.3, 2));
+
+		option o(D_);
+		option o4(D4);
+		auto D4_ = r.discrete(r.find(20));
+		option o4_(D4_);
+		assert(o4_.value(100., 0.2, 100.) == o4.value(100., 0.2, 100.));
+		assert(o.value(100., 0.2, -95.) == option(D).value(100., 0.2, -95.));
+
+		auto Df_ = r.discrete<float>(r.find(40));
+		assert(Df_.cdf(0.f) == 0.5f);
+
+		// wrong kind or scalar
+		try {
+			r.normal(r.find(30));
+			assert(false);
+		}
+		catch (const std::exception&) { }
+		try {
+			r.discrete(r.find(40));
+			assert(false);
+		}
+		catch (const std::exception&) { }
+	}
+	{
+		// corrupt copies are rejected when opened
+		memory_map m(file);
+		std::vector<uint64_t> b(m.size() / sizeof(uint64_t));
+		std::memcpy(b.data(), m.data(), m.size());
+		auto bad = [&](size_t i, uint64_t x) {
+			std::vector<uint64_t> b_(b);
+			b_[i] = x;
+			try {
+				snapshot::reader r(b_.data(), b_.size() * sizeof(uint64_t));
+				return false;
+			}
+			catch (const std::exception&) {
+				return true;
+			}
+		};
+		snapshot::reader r(b.data(), b.size() * sizeof(uint64_t));
+		assert(r.size() == 4);
+		assert(bad(0, 0)); // magic
+		assert(bad(1, 2)); // version
+		assert(bad(3, 1000)); // size
+		assert(bad(4 + 3, 1 << 20)); // offset of first entry
+	}
+	std::remove(file);
+	{
+		snapshot::writer w;
+		w.write(file);
+		snapshot::reader r(file);
+		assert(r.size() == 0);
+		assert(r.find(1) == 0);
+	}
+	std::remove(file);
+
+	return 0;
+}
+int test_snapshot_ = test_snapshot();
@@ -0,0 +1,191 @@
+// fms_term_structure.h - value an expiry by strike book over forward and vol curves
+// Curves are forwards f_i and vols s_i = sigma_i sqrt(t_i) at expiries t_i. Forwards are
+// log linear and total variance s^2 is linear between expiries, flat in sigma outside.
+// The book is grouped by expiry so f, s and cumulant(s) are computed once per expiry
+// and each expiry is valued as a strip. Expiries are valued in parallel.
+// Total variance must not decrease with expiry. Quotes at expiries where it does
+// are flagged in the same pass since they admit calendar arbitrage.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_option.h"
+
+namespace fms {
+
+	template<class X = double>
+	class term_structure {
+		std::vector<X> t; // expiries
+		std::vector<X> f; // forwards
+		std::vector<X> w; // total variance
+
+		// largest i with t[i] <= t_, or 0
+		size_t index(X t_) const noexcept
+		{
+			size_t i = std::upper_bound(t.begin(), t.end(), t_) - t.begin();
+
+			return i > 0 ? i - 1 : 0;
+		}
+	public:
+		term_structure()
+		{ }
+		// m expiries t with forwards f and vols s
+		term_structure(size_t m, const X* t, const X* f, const X* s)
+			: t(t, t + m), f(f, f + m), w(s, s + m)
+		{
+			ensure(m > 0);
+			ensure(std::is_sorted(this->t.begin(), this->t.end()));
+			ensure(this->t.front() > 0);
+
+			for (auto& w_ : w) {
+				ensure(w_ >= 0);
+				w_ *= w_;
+			}
+		}
+		term_structure(const term_structure&) = default;
+		term_structure& operator=(const term_structure&) = default;
+		~term_structure()
+		{ }
+
+		size_t size() const noexcept
+		{
+			return t.size();
+		}
+
+		X forward(X t_) const noexcept
+		{
+			if (t_ <= t.front()) {
+				return f.front();
+			}
+			if (t_ >= t.back()) {
+				return f.back();
+			}
+
+			size_t i = index(t_);
+			X u = (t_ - t[i]) / (t[i + 1] - t[i]);
+
+			return f[i] * ::pow(f[i + 1] / f[i], u);
+		}
+
+		// total variance s^2 at t_
+		X variance(X t_) const noexcept
+		{
+			if (t_ <= t.front()) {
+				return w.front() * t_ / t.front();
+			}
+			if (t_ >= t.back()) {
+				return w.back() * t_ / t.back();
+			}
+
+			size_t i = index(t_);
+			X u = (t_ - t[i]) / (t[i + 1] - t[i]);
+
+			return w[i] + u * (w[i + 1] - w[i]);
+		}
+		X vol(X t_) const noexcept
+		{
+			return ::sqrt(variance(t_));
+		}
+
+		// Total variance decreases into expiry i.
+		bool calendar(size_t i) const noexcept
+		{
+			return i > 0 and w[i] < w[i - 1];
+		}
+
+		// Value n options with expiry t_[i] and strike k[i], negative for put, using up to
+		// threads threads. If arb is not null arb[i] is set when total variance at t_[i] is
+		// below that at an earlier expiry. Returns the number of distinct expiries.
+		template<class M>
+		size_t value(const option<M>& o, size_t n, const X* t_, const X* k, X* v,
+			bool* arb = nullptr, unsigned threads = 0) const
+		{
+			// book order sorted by expiry then strike
+			std::vector<size_t> p(n);
+			std::iota(p.begin(), p.end(), size_t(0));
+			std::sort(p.begin(), p.end(), [t_, k](size_t i, size_t j) {
+				return t_[i] < t_[j] or (t_[i] == t_[j] and k[i] < k[j]);
+			});
+
+			// start of each expiry in p
+			std::vector<size_t> g;
+			for (size_t i = 0; i < n; ++i) {
+				if (i == 0 or t_[p[i]] != t_[p[i - 1]]) {
+					ensure(t_[p[i]] > 0);
+					g.push_back(i);
+				}
+			}
+			size_t m = g.size();
+			g.push_back(n);
+
+			// forward, vol and calendar check once per expiry
+			std::vector<X> fg(m), sg(m);
+			X wmax = 0;
+			for (size_t j = 0; j < m; ++j) {
+				X t0 = t_[p[g[j]]];
+				X w0 = variance(t0);
+				fg[j] = forward(t0);
+				sg[j] = ::sqrt(w0);
+				if (arb) {
+					for (size_t i = g[j]; i < g[j + 1]; ++i) {
+						arb[p[i]] = w0 < wmax;
+					}
+				}
+				wmax = (std::max)(wmax, w0);
+			}
+
+			if (threads == 0) {
+				threads = (std::max)(1u, std::thread::hardware_concurrency());
+			}
+			threads = static_cast<unsigned>((std::min)(size_t(threads), m));
+
+			std::atomic<size_t> next = 0;
+			std::exception_ptr e;
+			std::mutex em;
+			auto work = [&]() {
+				std::vector<X> kj, vj;
+
+				try {
+					for (size_t j = next++; j < m; j = next++) {
+						size_t nj = g[j + 1] - g[j];
+						kj.resize(nj);
+						vj.resize(nj);
+						for (size_t i = 0; i < nj; ++i) {
+							kj[i] = k[p[g[j] + i]];
+						}
+						o.value(fg[j], sg[j], nj, kj.data(), vj.data());
+						for (size_t i = 0; i < nj; ++i) {
+							v[p[g[j] + i]] = vj[i];
+						}
+					}
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lock(em);
+					e = std::current_exception();
+					next = m;
+				}
+			};
+
+			std::vector<std::thread> ts;
+			for (unsigned i = 1; i < threads; ++i) {
+				ts.emplace_back(work);
+			}
+			work();
+			for (auto& t0 : ts) {
+				t0.join();
+			}
+			if (e) {
+				std::rethrow_exception(e);
+			}
+
+			return m;
+		}
+	};
+
+}
@@ -0,0 +1,70 @@
+// fms_term_structure.t.cpp - test term structure pricer
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "fms_variate_normal.h"
+#include "fms_term_structure.h"
+
+using namespace fms;
+
+template<class X = double>
+int test_term_structure()
+{
+	X eps = 10 * std::numeric_limits<X>::epsilon();
+	X t[] = { X(0.25), X(0.5), X(1) };
+	X f[] = { 100, 101, 103 };
+	X s[] = { X(0.2) * X(0.5), X(0.25) * ::sqrt(X(0.5)), X(0.2) };
+
+	term_structure<X> ts(3, t, f, s);
+	{
+		assert(ts.size() == 3);
+		assert(ts.forward(X(0.5)) == 101);
+		assert(fabs(ts.vol(X(0.5)) - s[1]) < eps);
+		// flat in sigma outside expiries
+		assert(fabs(ts.vol(X(4)) - X(0.4)) < eps);
+		assert(fabs(ts.vol(X(0.0625)) - X(0.05)) < eps);
+		assert(!ts.calendar(1) and !ts.calendar(2));
+	}
+	{
+		// book out of order matches option by option valuation
+		variate::normal_impl<X> N;
+		option o(N);
+
+		std::vector<X> t_, k_;
+		for (size_t i = 0; i < 200; ++i) {
+			t_.push_back(X(0.1) * X(1 + (i * 7) % 13));
+			X k = X(80) + X((i * 11) % 41);
+			k_.push_back(k < 100 ? -k : k);
+		}
+		std::vector<X> v(t_.size()), v1(t_.size());
+		bool arb[200];
+
+		size_t m = ts.value(o, t_.size(), t_.data(), k_.data(), v.data(), arb, 4);
+		assert(m == 13);
+		ts.value(o, t_.size(), t_.data(), k_.data(), v1.data(), nullptr, 1);
+		for (size_t i = 0; i < t_.size(); ++i) {
+			X v_ = o.value(ts.forward(t_[i]), ts.vol(t_[i]), k_[i]);
+			assert(fabs(v[i] - v_) < 100 * eps);
+			assert(v[i] == v1[i]);
+			assert(!arb[i]);
+		}
+	}
+	{
+		// total variance decreases from 0.5 to 1
+		X s_[] = { s[0], s[1], X(0.15) };
+		term_structure<X> ts_(3, t, f, s_);
+		assert(ts_.calendar(2));
+
+		variate::normal_impl<X> N;
+		option o(N);
+		X t_[] = { X(1), X(0.5), X(0.75), X(0.25) };
+		X k_[] = { 100, 100, 100, 100 };
+		X v[4];
+		bool arb[4];
+		ts_.value(o, 4, t_, k_, v, arb);
+		assert(arb[0] and !arb[1] and arb[2] and !arb[3]);
+	}
+
+	return 0;
+}
+int test_term_structure_d = test_term_structure<double>();
@@ -27,7 +27,7 @@ inline auto test_derivative(auto& f, auto& df, X dx, X a, X b, X h)
 		if (err < lo) {
 			lo = err;
 		}
-		else if (err > hi) {
+		if (err > hi) {
 			hi = err;
 		}
 	}
@@ -61,3 +61,17 @@ inline int test_variate(const M& m, X dx)
 
 	return 0;
 }
+
+// max |edf(x, s) - (d/ds) cdf(x, s)| over [a, b) in steps of h using central differences
+template<class M, class X = M::xtype, class S = M::stype>
+inline X test_variate_edf(const M& m, S s, X a, X b, X h, S ds = S(1e-5))
+{
+	X err = 0;
+
+	for (X x = a; x < b; x += h) {
+		X d = (m.cdf(x, s + ds) - m.cdf(x, s - ds)) / X(2 * ds);
+		err = std::max(err, X(fabs(d - m.edf(x, s))));
+	}
+
+	return err;
+}
@@ -3,8 +3,10 @@
 #include <cmath>
 #include <algorithm>
 #include <compare>
+#include <limits>
 #include <numeric>
 #include <valarray>
+#include "fms_bell.h"
 #include "fms_ensure.h"
 
 template<class X>
@@ -25,10 +27,130 @@ inline auto operator<=>(const std::valarray<X>& x, const std::valarray<X>& y)
 
 namespace fms::variate {
 
-	template<class X = double, class S = X>
+	// (d/ds)^n sum_i exp(s x_i) p_i = sum_i exp(s x_i) x_i^n p_i
+	template<class X, class S>
+	inline S discrete_e(size_t m, const X* x, const X* p, S s, size_t n) noexcept
+	{
+		S E = 0;
+
+		for (size_t i = 0; i < m; ++i) {
+			E += ::exp(s * S(x[i])) * ::pow(S(x[i]), S(n)) * S(p[i]);
+		}
+
+		return E;
+	}
+
+	template<class X, class S>
+	inline X discrete_cdf(size_t m, const X* x, const X* p, X x_, S s, size_t n) noexcept
+	{
+		if (n == 0) {
+			X P = 0;
+			S ks = ::log(discrete_e(m, x, p, s, 0));
+
+			// return sum(exp(s*x[x <= x_] - cumulant(s))*p[x <= x_]);
+			for (size_t i = 0; i < m; ++i) {
+				P += (x[i] <= x_) * ::exp(s * x[i] - ks) * p[i];
+			}
+
+			return P;
+		}
+
+		// return infinity at point masses
+		return x + m == std::find(x, x + m, x_) ? X(0) : std::numeric_limits<X>::infinity();
+	}
+
+	// (d/ds) discrete_cdf(x_, s, 0) = sum_{x_i <= x_} (x_i - kappa'(s)) exp(s x_i - kappa(s)) p_i
+	template<class X, class S>
+	inline X discrete_edf(size_t m, const X* x, const X* p, X x_, S s) noexcept
+	{
+		S e0 = discrete_e(m, x, p, s, 0);
+		S ks = ::log(e0);
+		S k1 = discrete_e(m, x, p, s, 1) / e0;
+		X D = 0;
+
+		for (size_t i = 0; i < m; ++i) {
+			D += (x[i] <= x_) * (x[i] - X(k1)) * ::exp(s * x[i] - ks) * p[i];
+		}
+
+		return D;
+	}
+
+	template<class X, class S>
+	inline S discrete_cumulant(size_t m, const X* x, const X* p, S s, size_t n) noexcept
+	{
+		S e0 = discrete_e(m, x, p, s, 0);
+		if (n == 0) {
+			return ::log(e0);
+		}
+
+		S e1 = discrete_e(m, x, p, s, 1);
+		if (n == 1) {
+			return e1 / e0;
+		}
+
+		S e2 = discrete_e(m, x, p, s, 2);
+		if (n == 2) {
+			return (e0 * e2 - e1 * e1) / (e0 * e0);
+		}
+
+		if (n >= BELL_MAX) {
+			return std::numeric_limits<S>::quiet_NaN();
+		}
+
+		// kappa^(n) from derivatives of log e(s)
+		S mu[BELL_MAX], kappa[BELL_MAX];
+		mu[0] = 1;
+		mu[1] = e1 / e0;
+		mu[2] = e2 / e0;
+		for (size_t j = 3; j <= n; ++j) {
+			mu[j] = discrete_e(m, x, p, s, j) / e0;
+		}
+		cumulant_from_moment(n, mu, kappa);
+
+		return kappa[n - 1];
+	}
+
+	// Scale probabilities so a left to right sum is 1 to within epsilon,
+	// as checked by the discrete constructors.
+	template<class X>
+	inline void discrete_normalize(size_t m, X* p) noexcept
+	{
+		X P = 0;
+		for (size_t i = 0; i < m; ++i) {
+			p[i] = (std::max)(p[i], X(0));
+			P += p[i];
+		}
+		for (size_t i = 0; i < m; ++i) {
+			p[i] /= P;
+		}
+
+		// push rounding error into the largest probability
+		X* pmax = std::max_element(p, p + m);
+		for (int j = 0; j < 4; ++j) {
+			P = 0;
+			for (size_t i = 0; i < m; ++i) {
+				P += p[i];
+			}
+			if (P == 1) {
+				break;
+			}
+			*pmax += 1 - P;
+		}
+	}
+
+	// N > 0 is the fixed capacity of a discrete variate with inline storage
+	template<class X = double, class S = X, size_t N = 0>
 	class discrete {
 		std::valarray<X> x;
 		std::valarray<X> p;
+
+		// check the size before the pointer constructor reads n elements
+		static const X* begin(const std::initializer_list<X>& l, size_t n)
+		{
+			ensure(l.size() == n);
+
+			return l.begin();
+		}
 	public:
 		typedef X xtype;
 		typedef S stype;
@@ -47,10 +169,8 @@ namespace fms::variate {
 			ensure(fabs(p.sum() - X(1)) <= std::numeric_limits<X>::epsilon());
 		}
 		discrete(const std::initializer_list<X>& x, const std::initializer_list<X>& p)
-			: discrete(x.size(), x.begin(), p.begin())
-		{
-			ensure(x.size() == p.size());
-		}
+			: discrete(x.size(), x.begin(), begin(p, x.size()))
+		{ }
 		discrete(const discrete&) = default;
 		discrete& operator=(const discrete&) = default;
 		~discrete()
@@ -58,71 +178,157 @@ namespace fms::variate {
 
 		//auto operator<=>(const discrete&) const = default;
 
+		size_t size() const noexcept
+		{
+			return x.size();
+		}
+		X atom(size_t i) const
+		{
+			return x[i];
+		}
+		X probability(size_t i) const
+		{
+			return p[i];
+		}
+
 		X cdf(X x_, S s = 0, size_t n = 0) const noexcept
 		{
-			if (n == 0) {
-				X P = 0;
-				S ks = cumulant(s);
+			return discrete_cdf(x.size(), std::begin(x), std::begin(p), x_, s, n);
+		}
+		// (d/ds) cdf(x_, s, 0)
+		X edf(X x_, S s) const noexcept
+		{
+			return discrete_edf(x.size(), std::begin(x), std::begin(p), x_, s);
+		}
+		S cumulant(S s, size_t n = 0) const noexcept
+		{
+			return discrete_cumulant(x.size(), std::begin(x), std::begin(p), s, n);
+		}
+	};
 
-				// return sum(exp(s*x[x <= x_] - cumulant(s))*p[x <= x_]);
-				for (size_t i = 0; i < x.size(); ++i) {
-					P += (x[i] <= x_) * ::exp(s*x[i] - ks)*p[i];
-				}
+	// Fixed capacity discrete variate with no heap allocation.
+	// Atoms and probabilities are stored in one cache aligned block
+	// so copies are a memcpy and small lattices can be constexpr.
+	template<class X, class S, size_t N>
+		requires (N > 0)
+	class discrete<X, S, N> {
+		struct alignas(64) {
+			X x[N];
+			X p[N];
+		} xp;
+		size_t m;
 
-				return P;
-			}
+		// check the size before the pointer constructor reads n elements
+		static constexpr const X* begin(const std::initializer_list<X>& l, size_t n)
+		{
+			ensure(l.size() == n);
 
-			// return infinity at point masses
-			return std::end(x) == std::find(std::begin(x), std::end(x), x_) ? X(0) : std::numeric_limits<X>::infinity();
+			return l.begin();
 		}
-		S cumulant(S s, size_t n = 0) const noexcept
+	public:
+		typedef X xtype;
+		typedef S stype;
+
+		// zero
+		constexpr discrete()
+			: xp{}, m(1)
 		{
-			S e0 = e(s, 0);
-			if (n == 0) {
-				return ::log(e0);
-			}
+			xp.p[0] = 1;
+		}
+		constexpr discrete(size_t n, const X* _x, const X* _p)
+			: xp{}, m(n)
+		{
+			ensure(0 < n and n <= N);
 
-			S e1 = e(s, 1);
-			if (n == 1) {
-				return e1 / e0;
+			X P = 0;
+			for (size_t i = 0; i < n; ++i) {
+				xp.x[i] = _x[i];
+				xp.p[i] = n == 1 ? X(1) : _p[i];
+				ensure(0 <= xp.p[i]);
+				P += xp.p[i];
 			}
+			ensure(P - X(1) <= std::numeric_limits<X>::epsilon());
+			ensure(X(1) - P <= std::numeric_limits<X>::epsilon());
+		}
+		constexpr discrete(const std::initializer_list<X>& x, const std::initializer_list<X>& p)
+			: discrete(x.size(), x.begin(), begin(p, x.size()))
+		{ }
+		constexpr discrete(const discrete&) = default;
+		constexpr discrete& operator=(const discrete&) = default;
+		constexpr ~discrete() = default;
 
-			S e2 = e(s, 2);
-			if (n == 2) {
-				return (e0 * e2 - e1 * e1) / (e0 * e0);
-			}
+		constexpr size_t size() const noexcept
+		{
+			return m;
+		}
+		constexpr X atom(size_t i) const
+		{
+			return xp.x[i];
+		}
+		constexpr X probability(size_t i) const
+		{
+			return xp.p[i];
+		}
 
-			return std::numeric_limits<S>::quiet_NaN();
+		X cdf(X x_, S s = 0, size_t n = 0) const noexcept
+		{
+			return discrete_cdf(m, xp.x, xp.p, x_, s, n);
+		}
+		// (d/ds) cdf(x_, s, 0)
+		X edf(X x_, S s) const noexcept
+		{
+			return discrete_edf(m, xp.x, xp.p, x_, s);
 		}
-	private:
-		// (d/ds)^n sum_i exp(s x_i) p_i = sum_i exp(s x_i) x_i^n p_i
-		S e(S s, size_t n) const
+		S cumulant(S s, size_t n = 0) const noexcept
 		{
-			S E = 0;
+			return discrete_cumulant(m, xp.x, xp.p, s, n);
+		}
+	};
 
-			// return sum(exp(s*x)*pow(s)*p);
-			for (size_t i = 0; i < x.size(); ++i) {
-				E += ::exp(s * S(x[i])) * ::pow(S(x[i]), S(n)) * S(p[i]);
-			}
+	// Atoms and probabilities stored elsewhere, e.g. in a mapped snapshot.
+	// The storage must outlive the view.
+	template<class X = double, class S = X>
+	class discrete_view {
+		size_t m;
+		const X* x;
+		const X* p;
+	public:
+		typedef X xtype;
+		typedef S stype;
 
-			return E;
+		constexpr discrete_view(size_t m, const X* x, const X* p) noexcept
+			: m(m), x(x), p(p)
+		{ }
+		constexpr discrete_view(const discrete_view&) = default;
+		constexpr discrete_view& operator=(const discrete_view&) = default;
+		constexpr ~discrete_view() = default;
+
+		constexpr size_t size() const noexcept
+		{
+			return m;
 		}
-		// exponential Bell polynomials
-		inline constexpr S B(size_t n, size_t k, S s)
+		constexpr X atom(size_t i) const
 		{
-			if (n == 0) {
-				if (k == 0)
-					return S(1);
-				else
-					return S(0);
-			}
-			if (k == 0) {
-				return S(0);
-			}
+			return x[i];
+		}
+		constexpr X probability(size_t i) const
+		{
+			return p[i];
+		}
 
-			return s;
+		X cdf(X x_, S s = 0, size_t n = 0) const noexcept
+		{
+			return discrete_cdf(m, x, p, x_, s, n);
+		}
+		// (d/ds) cdf(x_, s, 0)
+		X edf(X x_, S s) const noexcept
+		{
+			return discrete_edf(m, x, p, x_, s);
+		}
+		S cumulant(S s, size_t n = 0) const noexcept
+		{
+			return discrete_cumulant(m, x, p, s, n);
 		}
 	};
 
 }
-
@@ -1,5 +1,6 @@
 // fms_variate_discrete.t.cpp - test discrete variate
 #include <cassert>
+#include <type_traits>
 #include "fms_variate_discrete.h"
 
 using namespace fms;
@@ -49,6 +50,12 @@ int test_variate_discrete()
 			X err = x.cumulant(s);
 			err -= ::log(::cosh(s));
 			assert(fabs(err) <= std::numeric_limits<X>::epsilon());
+
+			// cdf(0, s) = 1/(1 + exp(2s))
+			X cs = ::cosh(s);
+			assert(fabs(x.edf(0, s) + 1 / (2 * cs * cs)) <= 2 * std::numeric_limits<X>::epsilon());
+			assert(x.edf(-2, s) == 0);
+			assert(fabs(x.edf(2, s)) <= std::numeric_limits<X>::epsilon());
 		}
 
 	}
@@ -58,3 +65,65 @@ int test_variate_discrete()
 }
 int test_variate_discrete_d = test_variate_discrete<double>();
 int test_variate_discrete_f = test_variate_discrete<float>();
+
+template<class X = double>
+int test_variate_discrete_fixed()
+{
+	// binomial and trinomial lattices baked in at compile time
+	constexpr variate::discrete<X, X, 2> b({ -1, 1 }, { 0.5, 0.5 });
+	static_assert(b.size() == 2);
+	static_assert(b.atom(0) == -1 and b.probability(1) == 0.5);
+	constexpr X sqrt2 = X(1.41421356237309504880);
+	constexpr variate::discrete<X, X, 3> t({ -sqrt2, 0, sqrt2 }, { 0.25, 0.5, 0.25 });
+	static_assert(t.size() == 3);
+	static_assert(std::is_trivially_copyable_v<variate::discrete<X, X, 3>>);
+	static_assert(alignof(variate::discrete<X, X, 3>) == 64);
+
+	{
+		variate::discrete<X, X, 4> x;
+		variate::discrete<X, X, 4> x2(x);
+		x = x2;
+
+		assert(x.size() == 1);
+		assert(x.cdf(-1) == 0);
+		assert(x.cdf(0) == 1);
+		assert(x.cumulant(0) == 0);
+	}
+	{
+		variate::discrete<X, X> x({ -1,1 }, { 0.5, 0.5 });
+		variate::discrete<X, X, 4> x4({ -1,1 }, { 0.5, 0.5 });
+
+		for (X x_ : {X(-2), X(-1), X(0), X(1), X(2)}) {
+			assert(b.cdf(x_) == x.cdf(x_));
+			assert(x4.cdf(x_, X(0.1)) == x.cdf(x_, X(0.1)));
+			assert(x4.edf(x_, X(0.1)) == x.edf(x_, X(0.1)));
+		}
+		for (X s : {X(-1), X(0), X(0.1), X(1)}) {
+			for (size_t n : {0, 1, 2}) {
+				assert(b.cumulant(s, n) == x.cumulant(s, n));
+			}
+		}
+	}
+	{
+		// sizes are checked before the lists are read
+		bool thrown = false;
+		try {
+			variate::discrete<X, X, 4> x4({ -1, 0, 1 }, { 0.5, 0.5 });
+		}
+		catch (const std::exception&) {
+			thrown = true;
+		}
+		assert(thrown);
+	}
+	{
+		assert(t.cumulant(0, 1) == 0);
+		assert(fabs(t.cumulant(0, 2) - 1) <= 2 * std::numeric_limits<X>::epsilon());
+		assert(t.cdf(-2) == 0);
+		assert(t.cdf(0) == X(0.75));
+		assert(t.cdf(2) == 1);
+	}
+
+	return 0;
+}
+int test_variate_discrete_fixed_d = test_variate_discrete_fixed<double>();
+int test_variate_discrete_fixed_f = test_variate_discrete_fixed<float>();
@@ -0,0 +1,168 @@
+// fms_variate_edgeworth.h - Edgeworth expansion of the standard normal
+// Density phi(x) g(x) with g(x) = 1 + skew/6 H_3(x) + kurt/24 H_4(x) + skew^2/72 H_6(x)
+// where kurt is excess kurtosis. Mean 0, variance 1, skew and kurt are exact.
+// Since int exp(sx) phi(x) H_j(x) dx = s^j exp(s^2/2) the cumulant is
+// kappa(s) = s^2/2 + log D(s) where D(s) = sum_j g_j s^j, and the Esscher
+// transform has density phi(x - s) g(x)/D(s). Using H_j(y + s) = sum_i C(j, i) s^{j-i} H_i(y)
+// and int_{-infty}^y phi H_i = -phi(y) H_{i-1}(y) the cdf is closed form.
+#pragma once
+#include <cmath>
+#include <limits>
+#include "fms_bell.h"
+#include "fms_ensure.h"
+#include "fms_variate_normal.h"
+
+namespace fms::variate {
+
+	template<class X = double, class S = X>
+	class edgeworth {
+		static constexpr size_t N = 7; // H_0, ..., H_6
+		typedef normal_impl<X, S> normal;
+		X g[N]; // coefficient of H_j in g(x)
+
+		// D^(n)(s) = sum_j g_j j!/(j - n)! s^{j - n}
+		S D(S s, size_t n = 0) const noexcept
+		{
+			S d = 0;
+
+			for (size_t j = N; j-- > n; ) {
+				S c = S(g[j]);
+				for (size_t i = 0; i < n; ++i) {
+					c *= S(j - i);
+				}
+				d = d * s + c;
+			}
+
+			return d;
+		}
+
+		// int_{-infty}^x phi(t - s) sum_j a_j H_j(t) dt for a_0, ..., a_{N-1}
+		static X integral(const X* a, X x, S s)
+		{
+			X y = x - X(s);
+			X h[N];
+			normal::H(N - 1, y, h);
+
+			// c_i = sum_j a_j C(j, i) s^{j - i}
+			X c[N];
+			for (size_t i = 0; i < N; ++i) {
+				X ci = 0;
+				for (size_t j = N; j-- > i; ) {
+					ci = ci * X(s) + a[j] * X(binomial(j, i));
+				}
+				c[i] = ci;
+			}
+
+			X I = c[0] * normal::cdf01(y);
+			X phi = normal::cdf01(y, 1);
+			for (size_t i = 1; i < N; ++i) {
+				I -= phi * c[i] * h[i - 1];
+			}
+
+			return I;
+		}
+	public:
+		typedef X xtype;
+		typedef S stype;
+
+		// skew and excess kurtosis
+		edgeworth(X skew = 0, X kurt = 0)
+			: g{ 1, 0, 0, skew / 6, kurt / 24, 0, skew * skew / 72 }
+		{ }
+		edgeworth(const edgeworth&) = default;
+		edgeworth& operator=(const edgeworth&) = default;
+		~edgeworth()
+		{ }
+
+		X skew() const noexcept
+		{
+			return 6 * g[3];
+		}
+		X kurt() const noexcept
+		{
+			return 24 * g[4];
+		}
+
+		X cdf(X x, S s = 0, size_t n = 0) const
+		{
+			X y = x - X(s);
+			X phi = normal::cdf01(y, 1);
+
+			if (n == 0) {
+				X d = X(D(s));
+				ensure(d > 0);
+
+				return integral(g, x, s) / d;
+			}
+
+			ensure(n <= BELL_MAX);
+
+			// (d/dx)^{n-1} phi(y) g(x) = sum_i C(n - 1, i) (-1)^i H_i(y) phi(y) g^(n-1-i)(x)
+			X hx[N];
+			normal::H(N - 1, x, hx);
+			X Hy[BELL_MAX];
+			normal::H(n - 1, y, Hy);
+
+			X p = 0;
+			for (size_t i = 0; i < n; ++i) {
+				size_t r = n - 1 - i; // order of derivative of g
+				X gr = 0;
+				for (size_t j = r; j < N; ++j) {
+					X c = g[j];
+					for (size_t l = 0; l < r; ++l) {
+						c *= X(j - l);
+					}
+					gr += c * hx[j - r];
+				}
+				p += X(binomial(n - 1, i)) * ((i & 1) ? -1 : 1) * Hy[i] * gr;
+			}
+
+			return phi * p / X(D(s));
+		}
+
+		// (d/ds) cdf(x, s, 0) = (d/ds) I(s)/D(s) where I(s) = int_{-infty}^x phi(t - s) g(t) dt.
+		// Integrating by parts I'(s) = -phi(x - s) g(x) + int_{-infty}^x phi(t - s) g'(t) dt
+		// and g' = sum_j j g_j H_{j-1} since H_j' = j H_{j-1}.
+		X edf(X x, S s) const
+		{
+			X d = X(D(s));
+			ensure(d > 0);
+
+			X h[N];
+			normal::H(N - 1, x, h);
+			X gx = 0, dg[N];
+			for (size_t j = 0; j < N; ++j) {
+				gx += g[j] * h[j];
+				dg[j] = j + 1 < N ? X(j + 1) * g[j + 1] : X(0);
+			}
+
+			X dI = -normal::cdf01(x - X(s), 1) * gx + integral(dg, x, s);
+
+			return (dI - integral(g, x, s) * X(D(s, 1)) / d) / d;
+		}
+
+		S cumulant(S s, size_t n = 0) const
+		{
+			S d = D(s);
+			ensure(d > 0);
+
+			if (n == 0) {
+				return s * s / 2 + ::log(d);
+			}
+			if (n >= BELL_MAX) {
+				return std::numeric_limits<S>::quiet_NaN();
+			}
+
+			// (d/ds)^n log D(s)
+			S m[BELL_MAX], kappa[BELL_MAX];
+			m[0] = 1;
+			for (size_t j = 1; j <= n; ++j) {
+				m[j] = D(s, j) / d;
+			}
+			cumulant_from_moment(n, m, kappa);
+
+			return normal::cumulant01(s, n) + kappa[n - 1];
+		}
+	};
+
+}
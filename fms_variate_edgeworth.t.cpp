@@ -0,0 +1,76 @@
+// fms_variate_edgeworth.t.cpp - test Edgeworth variate
+#include <cassert>
+#include <cmath>
+#include "fms_test.h"
+#include "fms_option.h"
+#include "fms_variate_edgeworth.h"
+
+using namespace fms;
+
+template<class X = double>
+int test_variate_edgeworth()
+{
+	X eps = std::numeric_limits<X>::epsilon();
+
+	{
+		variate::edgeworth<X> e;
+		variate::normal_impl<X> n;
+
+		for (X x : {X(-2), X(0), X(0.5)}) {
+			for (X s : {X(0), X(0.1), X(1)}) {
+				assert(fabs(e.cdf(x, s) - n.cdf(x, s)) <= 2 * eps);
+				assert(fabs(e.cdf(x, s, 1) - n.cdf(x, s, 1)) <= 2 * eps);
+				assert(fabs(e.cdf(x, s, 3) - n.cdf(x, s, 3)) <= 2 * eps);
+			}
+			assert(e.cumulant(x) == n.cumulant(x));
+			assert(fabs(e.edf(x, X(0.2)) - n.edf(x, X(0.2))) <= 2 * eps);
+		}
+	}
+	{
+		X skew = X(-0.3);
+		X kurt = X(0.5);
+		variate::edgeworth<X> e(skew, kurt);
+
+		assert(e.skew() == skew);
+		assert(e.kurt() == kurt);
+		assert(e.cumulant(0) == 0);
+		assert(e.cumulant(0, 1) == 0);
+		assert(e.cumulant(0, 2) == 1);
+		assert(fabs(e.cumulant(0, 3) - skew) <= eps);
+		assert(fabs(e.cumulant(0, 4) - kurt) <= 4 * eps);
+
+		assert(e.cdf(-10) < 1e-12);
+		assert(fabs(e.cdf(10, X(0.2)) - 1) < 1e-12);
+
+		// d/dx cdf(x, s, n) = cdf(x, s, n + 1)
+		test_variate(e, X(0.001));
+
+		// d/ds kappa^(n)(s) = kappa^(n+1)(s)
+		X s = X(0.2), h = X(1e-4);
+		for (size_t n : {0, 1, 2, 3}) {
+			X dk = (e.cumulant(s + h, n) - e.cumulant(s - h, n)) / (2 * h);
+			assert(fabs(dk - e.cumulant(s, n + 1)) < 1e-6);
+		}
+		for (X s_ : {X(-0.5), X(0), X(0.2), X(1)}) {
+			assert(test_variate_edf(e, s_, X(-4), X(4), X(0.25)) < 1e-8);
+		}
+	}
+	{
+		variate::edgeworth<X> e(X(-0.3), X(0.5));
+		option o(e);
+		X f = 100, s = X(0.2);
+
+		for (X k : {X(80), X(100), X(120)}) {
+			X c = o.value(f, s, payoff::call(k));
+			X p = o.value(f, s, payoff::put(k));
+			assert(fabs(c - p - (f - k)) < 1e-12);
+
+			X h = X(1e-5);
+			X dv = (o.value(f, s + h, k) - o.value(f, s - h, k)) / (2 * h);
+			assert(fabs(o.vega(f, s, k) - dv) < 1e-6);
+		}
+	}
+
+	return 0;
+}
+int test_variate_edgeworth_d = test_variate_edgeworth<double>();
@@ -0,0 +1,269 @@
+// fms_variate_empirical.h - rolling window empirical variate
+// Observations y are snapped to a fixed sorted support, e.g. tick quantized log returns.
+// A Fenwick tree over the support holds counts so adding or removing an observation
+// and cdf(x) are O(log n). Running sums keep the standardization X = (Y - mean)/sd
+// current in O(1). Esscher transforms, s != 0, need one pass over the support.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "fms_bell.h"
+#include "fms_ensure.h"
+#include "fms_variate_discrete.h"
+
+namespace fms::variate {
+
+	template<class X = double, class S = X>
+	class empirical {
+		std::vector<X> y;        // support
+		std::vector<size_t> c;   // count at each support point
+		std::vector<size_t> t;   // Fenwick tree of counts
+		std::vector<size_t> w;   // ring buffer of support indices
+		size_t head, m;          // oldest observation in window, number of observations
+		size_t updates;          // since sums were recomputed
+		long double sum, sum2;
+
+		size_t index(X y_) const
+		{
+			auto i = std::lower_bound(y.begin(), y.end(), y_);
+
+			if (i == y.end()) {
+				--i;
+			}
+			else if (i != y.begin() and y_ - *(i - 1) < *i - y_) {
+				--i;
+			}
+
+			return i - y.begin();
+		}
+		void update(size_t i, bool add)
+		{
+			if (add) {
+				++c[i];
+				++m;
+				for (size_t j = i + 1; j <= y.size(); j += j & (~j + 1)) {
+					++t[j - 1];
+				}
+			}
+			else {
+				ensure(c[i] > 0);
+				--c[i];
+				--m;
+				for (size_t j = i + 1; j <= y.size(); j += j & (~j + 1)) {
+					--t[j - 1];
+				}
+			}
+
+			// avoid drift from adding and subtracting the same values
+			if (++updates > y.size() + w.size()) {
+				sum = sum2 = 0;
+				for (size_t j = 0; j < y.size(); ++j) {
+					sum += c[j] * static_cast<long double>(y[j]);
+					sum2 += c[j] * static_cast<long double>(y[j]) * y[j];
+				}
+				updates = 0;
+			}
+			else {
+				long double yi = (add ? 1 : -1) * static_cast<long double>(y[i]);
+				sum += yi;
+				sum2 += yi * y[i];
+			}
+		}
+		// number of observations at support indices < i
+		size_t prefix(size_t i) const noexcept
+		{
+			size_t n = 0;
+
+			for (; i > 0; i -= i & (~i + 1)) {
+				n += t[i - 1];
+			}
+
+			return n;
+		}
+		// mean and positive standard deviation of the window
+		void moments(X& mu, X& sd) const
+		{
+			ensure(m > 1);
+			mu = mean();
+			sd = stddev();
+			ensure(sd > 0);
+		}
+		// Support points standardized the same way everywhere so comparisons agree at atoms.
+		// Rounding is monotone so the standardized support is sorted.
+		static X standard(X y_, X mu, X sd) noexcept
+		{
+			return (y_ - mu) / sd;
+		}
+		// number of support points with standardized value at most x
+		size_t upper(X x, X mu, X sd) const
+		{
+			return std::partition_point(y.begin(), y.end(), [=](X y_) { return standard(y_, mu, sd) <= x; }) - y.begin();
+		}
+		// sum_i c_i exp(s x_i) x_i^j for j = 0, ..., n with x the standardized support
+		void e(S s, size_t n, S* E) const
+		{
+			X mu, sd;
+			moments(mu, sd);
+
+			std::fill(E, E + n + 1, S(0));
+			for (size_t i = 0; i < y.size(); ++i) {
+				if (c[i]) {
+					S x = S(standard(y[i], mu, sd));
+					S a = S(c[i]) * ::exp(s * x);
+					for (size_t j = 0; j <= n; ++j) {
+						E[j] += a;
+						a *= x;
+					}
+				}
+			}
+		}
+	public:
+		typedef X xtype;
+		typedef S stype;
+
+		// n sorted support points and maximum window length for push
+		empirical(size_t n, const X* support, size_t window = 0)
+			: y(support, support + n), c(n), t(n), w(window), head(0), m(0), updates(0), sum(0), sum2(0)
+		{
+			ensure(n > 1);
+			ensure(std::is_sorted(y.begin(), y.end()));
+		}
+		empirical(const empirical&) = default;
+		empirical& operator=(const empirical&) = default;
+		~empirical()
+		{ }
+
+		size_t size() const noexcept
+		{
+			return m;
+		}
+		X mean() const noexcept
+		{
+			return X(sum / m);
+		}
+		X stddev() const noexcept
+		{
+			long double mu = sum / m;
+
+			return X(::sqrt(static_cast<long double>(sum2 / m - mu * mu)));
+		}
+
+		// O(log n)
+		void add(X y_)
+		{
+			update(index(y_), true);
+		}
+		void remove(X y_)
+		{
+			update(index(y_), false);
+		}
+		// add to the window and drop the oldest observation if it is full
+		void push(X y_)
+		{
+			ensure(w.size() > 0);
+
+			size_t i = index(y_);
+			if (m == w.size()) {
+				update(w[head], false);
+				w[head] = i;
+				head = (head + 1) % w.size();
+			}
+			else {
+				w[(head + m) % w.size()] = i;
+			}
+			update(i, true);
+		}
+
+		X cdf(X x, S s = 0, size_t n = 0) const
+		{
+			X mu, sd;
+			moments(mu, sd);
+			size_t j = upper(x, mu, sd);
+
+			if (n == 0) {
+				if (s == 0) {
+					return X(prefix(j)) / X(m);
+				}
+
+				S k = cumulant(s);
+				X P = 0;
+				for (size_t i = 0; i < j; ++i) {
+					if (c[i]) {
+						P += c[i] * ::exp(s * standard(y[i], mu, sd) - k);
+					}
+				}
+
+				return P / m;
+			}
+
+			// return infinity at point masses
+			return j > 0 and c[j - 1] and standard(y[j - 1], mu, sd) == x ? std::numeric_limits<X>::infinity() : X(0);
+		}
+
+		// (d/ds) cdf(x, s, 0) in one pass over the support for kappa and kappa'
+		X edf(X x, S s) const
+		{
+			X mu, sd;
+			moments(mu, sd);
+			S E[2];
+			e(s, 1, E);
+			S k = ::log(E[0] / m);
+			S k1 = E[1] / E[0];
+
+			X D = 0;
+			for (size_t i = 0, j = upper(x, mu, sd); i < j; ++i) {
+				if (c[i]) {
+					X x_ = standard(y[i], mu, sd);
+					D += c[i] * (x_ - X(k1)) * ::exp(s * x_ - k);
+				}
+			}
+
+			return D / m;
+		}
+
+		S cumulant(S s, size_t n = 0) const
+		{
+			ensure(m > 1);
+
+			if (s == 0 and n <= 2) {
+				return S(n == 2);
+			}
+			if (n >= BELL_MAX) {
+				return std::numeric_limits<S>::quiet_NaN();
+			}
+
+			S E[BELL_MAX + 1];
+			e(s, n, E);
+			if (n == 0) {
+				return ::log(E[0] / m);
+			}
+
+			S mu[BELL_MAX], kappa[BELL_MAX];
+			for (size_t j = 0; j <= n; ++j) {
+				mu[j] = E[j] / E[0];
+			}
+			cumulant_from_moment(n, mu, kappa);
+
+			return kappa[n - 1];
+		}
+
+		// snapshot as a discrete variate
+		discrete<X, S> model() const
+		{
+			X mu, sd;
+			moments(mu, sd);
+			std::vector<X> x, p;
+			for (size_t i = 0; i < y.size(); ++i) {
+				if (c[i]) {
+					x.push_back(standard(y[i], mu, sd));
+					p.push_back(X(c[i]) / X(m));
+				}
+			}
+			discrete_normalize(p.size(), p.data());
+
+			return discrete<X, S>(x.size(), x.data(), p.data());
+		}
+	};
+
+}
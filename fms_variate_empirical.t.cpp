@@ -0,0 +1,92 @@
+// fms_variate_empirical.t.cpp - test rolling window empirical variate
+#include <cassert>
+#include <cmath>
+#include "fms_variate_empirical.h"
+
+using namespace fms;
+
+template<class X = double>
+int test_variate_empirical()
+{
+	X eps = std::numeric_limits<X>::epsilon();
+
+	X y[21];
+	for (int i = 0; i < 21; ++i) {
+		y[i] = X(i - 10) / 100; // one percent ticks
+	}
+
+	{
+		variate::empirical<X> e(21, y);
+		e.add(X(-0.01));
+		e.add(X(0.011)); // snaps to 0.01
+		assert(e.size() == 2);
+		assert(fabs(e.mean()) <= eps);
+		assert(fabs(e.stddev() - X(0.01)) <= eps);
+		assert(e.cdf(-2) == 0);
+		assert(e.cdf(-1) == X(0.5));
+		assert(e.cdf(0) == X(0.5));
+		assert(e.cdf(1) == 1);
+		assert(e.cumulant(0) == 0 and e.cumulant(0, 1) == 0 and e.cumulant(0, 2) == 1);
+
+		// same as discrete
+		variate::discrete<X, X> d({ -1, 1 }, { 0.5, 0.5 });
+		for (X s : {X(-0.5), X(0.2)}) {
+			assert(fabs(e.cumulant(s) - d.cumulant(s)) <= 2 * eps);
+			for (size_t n : {1, 2, 3, 4}) {
+				assert(fabs(e.cumulant(s, n) - d.cumulant(s, n)) <= 10 * eps);
+			}
+			assert(fabs(e.cdf(0, s) - d.cdf(0, s)) <= 2 * eps);
+			assert(fabs(e.edf(0, s) - d.edf(0, s)) <= 2 * eps);
+		}
+
+		e.add(X(0.05));
+		e.remove(X(0.05));
+		assert(e.size() == 2);
+		assert(fabs(e.mean()) <= eps);
+	}
+	{
+		// window of 3
+		variate::empirical<X> e(21, y, 3);
+		X r[] = { X(0.02), X(-0.01), X(0.03), X(0), X(-0.05), X(0.01) };
+		for (X r_ : r) {
+			e.push(r_);
+		}
+		assert(e.size() == 3);
+		assert(fabs(e.mean() - (X(0) - X(0.05) + X(0.01)) / 3) <= eps);
+
+		auto d = e.model();
+		assert(d.size() == 3);
+		for (X x : {X(-1.5), X(0), X(0.7)}) {
+			assert(fabs(d.cdf(x) - e.cdf(x)) <= eps);
+			assert(fabs(d.cdf(x, X(0.3)) - e.cdf(x, X(0.3))) <= 10 * eps);
+		}
+		assert(fabs(d.cumulant(X(0.3), 3) - e.cumulant(X(0.3), 3)) <= 100 * eps);
+		for (X x : {X(-1.5), X(0), X(0.7)}) {
+			assert(fabs(d.edf(x, X(0.3)) - e.edf(x, X(0.3))) <= 10 * eps);
+		}
+		// atoms are standardized the same way for every s
+		for (size_t i = 0; i < d.size(); ++i) {
+			X x = d.atom(i);
+			assert(e.cdf(x) == d.cdf(x));
+			assert(fabs(e.cdf(x, X(1e-300)) - e.cdf(x)) <= 10 * eps);
+			assert(fabs(d.edf(x, X(0.3)) - e.edf(x, X(0.3))) <= 10 * eps);
+		}
+	}
+	{
+		// no dispersion
+		variate::empirical<X> e(21, y);
+		e.add(X(0.01));
+		e.add(X(0.01));
+		bool thrown = false;
+		try {
+			e.cdf(0);
+		}
+		catch (const std::exception&) {
+			thrown = true;
+		}
+		assert(thrown);
+	}
+
+	return 0;
+}
+int test_variate_empirical_d = test_variate_empirical<double>();
@@ -9,9 +9,11 @@
 #pragma once
 #define _USE_MATH_DEFINES 
 #include <cmath>
+#include <limits>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_sf_gamma.h>
 #include <gsl/gsl_sf_psi.h>
+#include "fms_beta.h"
 #include "fms_ensure.h"
 
 namespace fms::variate {
@@ -23,11 +25,13 @@ namespace fms::variate {
 
 		typedef X xtype;
 		typedef S stype;
+		// cumulant is finite for |s a| < 1
+		static constexpr S vol_max = S(M_PI) / S(M_SQRT3);
 
 		// Use incomplete beta function.
 		static X cdf(X x, S s = 0, size_t n = 0)
 		{
-			ensure(-1 < s and s < 1);
+			ensure(-vol_max < s and s < vol_max);
 
 			if (n == 0) {
 				X u = 1 / (1 + ::exp(-x / a));
@@ -35,7 +39,7 @@ namespace fms::variate {
 					return u;
 				}
 				else {
-					return gsl_sf_beta_inc(1 + s, 1 - s, u);
+					return gsl_sf_beta_inc(1 + s * a, 1 - s * a, u);
 				}
 			}
 
@@ -53,20 +57,36 @@ namespace fms::variate {
 			return std::numeric_limits<X>::quiet_NaN();
 	
 		}
-		// cumulant
+		// (d/ds) cdf(x, s, 0) where cdf = B_u(1 + sa, 1 - sa)/B(1 + sa, 1 - sa) and (d/ds) log B = kappa'(s).
+		// For u > 1/2 use I_u(1 + sa, 1 - sa) = 1 - I_{1-u}(1 - sa, 1 + sa) so the series converges fast.
+		static X edf(X x, S s)
+		{
+			ensure(-vol_max < s and s < vol_max);
+
+			bool flip = x > 0;
+			X w = 1 / (1 + ::exp((flip ? x : -x) / a)); // min(u, 1 - u)
+			S t = flip ? -s : s;
+			X b, db;
+			beta_inc(w, t * a, b, db);
+			X B = ::exp(cumulant(t));
+
+			return (a * db - b * X(cumulant(t, 1))) / B;
+		}
+
+		// kappa(s) = log Gamma(1 + sa) + log Gamma(1 - sa)
+		// kappa^(n)(s) = a^n (psi_{n-1}(1 + sa) + (-1)^n psi_{n-1}(1 - sa))
 		static S cumulant(S s, size_t n = 0)
 		{
-			ensure(-1 < s and s < 1);
+			ensure(-vol_max < s and s < vol_max);
 
 			if (n == 0) {
-				return gsl_sf_lngamma(1 + s) + gsl_sf_lngamma(1 - s);
+				return gsl_sf_lngamma(1 + s * a) + gsl_sf_lngamma(1 - s * a);
 			}
 
 			int n_ = static_cast<int>(n - 1);
 
-			return gsl_sf_psi_n(n_, 1 + s) - gsl_sf_psi_n(n_, 1 - s);
+			return ::pow(a, S(n)) * (gsl_sf_psi_n(n_, 1 + s * a) + (n % 2 ? -1 : 1) * gsl_sf_psi_n(n_, 1 - s * a));
 		}
-
 	};
 
 }
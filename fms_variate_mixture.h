@@ -0,0 +1,181 @@
+// fms_variate_mixture.h - mixture of K normal variates
+// X = sum_k 1(J = k) (mu_k + sigma_k Z) with P(J = k) = w_k, standardized to mean 0 variance 1.
+// kappa(s) = log sum_k w_k exp(mu_k s + sigma_k^2 s^2/2) and the Esscher transform is a
+// mixture of N(mu_k + sigma_k^2 s, sigma_k^2) with weights w_k exp(mu_k s + sigma_k^2 s^2/2 - kappa(s)).
+// Components are stored as structure of arrays and evaluated in one loop over K.
+#pragma once
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+#include "fms_bell.h"
+#include "fms_ensure.h"
+#include "fms_variate_normal.h"
+
+namespace fms::variate {
+
+	template<class X = double, class S = X, size_t K = 2>
+		requires (K > 0)
+	class mixture {
+		typedef normal_impl<X, S> normal;
+		struct alignas(64) {
+			X w[K];
+			X mu[K];
+			X sigma[K];
+			X lw[K]; // log w
+		} c;
+
+		// log weights of the Esscher transform a_k = log w_k + mu_k s + sigma_k^2 s^2/2 less the max
+		// Returns log sum_k exp(a_k) so q_k = exp(a_k) / sum
+		S tilt(S s, S* q) const noexcept
+		{
+			S amax = -std::numeric_limits<S>::infinity();
+			for (size_t k = 0; k < K; ++k) {
+				q[k] = S(c.lw[k]) + S(c.mu[k]) * s + S(c.sigma[k] * c.sigma[k]) * s * s / 2;
+				amax = q[k] > amax ? q[k] : amax;
+			}
+			S Q = 0;
+			for (size_t k = 0; k < K; ++k) {
+				q[k] = ::exp(q[k] - amax);
+				Q += q[k];
+			}
+			for (size_t k = 0; k < K; ++k) {
+				q[k] /= Q;
+			}
+
+			return amax + ::log(Q);
+		}
+
+		// check the size before the pointer constructor reads K elements
+		static const X* begin(const std::initializer_list<X>& l)
+		{
+			ensure(l.size() == K);
+
+			return l.begin();
+		}
+	public:
+		typedef X xtype;
+		typedef S stype;
+
+		// weights w, means mu and standard deviations sigma, standardized to mean 0 variance 1
+		mixture(const X* w, const X* mu, const X* sigma)
+			: c{}
+		{
+			X W = 0, m = 0, v = 0;
+			for (size_t k = 0; k < K; ++k) {
+				ensure(w[k] > 0);
+				ensure(sigma[k] > 0);
+				W += w[k];
+			}
+			for (size_t k = 0; k < K; ++k) {
+				c.w[k] = w[k] / W;
+				c.lw[k] = ::log(c.w[k]);
+				m += c.w[k] * mu[k];
+			}
+			for (size_t k = 0; k < K; ++k) {
+				v += c.w[k] * (sigma[k] * sigma[k] + (mu[k] - m) * (mu[k] - m));
+			}
+			X sd = ::sqrt(v);
+			for (size_t k = 0; k < K; ++k) {
+				c.mu[k] = (mu[k] - m) / sd;
+				c.sigma[k] = sigma[k] / sd;
+			}
+		}
+		mixture(const std::initializer_list<X>& w, const std::initializer_list<X>& mu, const std::initializer_list<X>& sigma)
+			: mixture(begin(w), begin(mu), begin(sigma))
+		{ }
+		mixture(const mixture&) = default;
+		mixture& operator=(const mixture&) = default;
+		~mixture()
+		{ }
+
+		constexpr size_t size() const noexcept
+		{
+			return K;
+		}
+		X weight(size_t k) const
+		{
+			return c.w[k];
+		}
+		X mean(size_t k) const
+		{
+			return c.mu[k];
+		}
+		X stddev(size_t k) const
+		{
+			return c.sigma[k];
+		}
+
+		X cdf(X x, S s = 0, size_t n = 0) const noexcept
+		{
+			S q[K];
+			tilt(s, q);
+
+			X P = 0;
+			for (size_t k = 0; k < K; ++k) {
+				X z = (x - c.mu[k]) / c.sigma[k] - c.sigma[k] * X(s);
+				P += X(q[k]) * normal::cdf01(z, n) / ::pow(c.sigma[k], X(n));
+			}
+
+			return P;
+		}
+
+		// (d/ds) cdf(x, s, 0) where dq_k/ds = q_k (u_k - kappa'(s)) with u_k = mu_k + sigma_k^2 s
+		X edf(X x, S s) const noexcept
+		{
+			S q[K];
+			tilt(s, q);
+
+			S k1 = 0;
+			for (size_t k = 0; k < K; ++k) {
+				k1 += q[k] * (S(c.mu[k]) + S(c.sigma[k] * c.sigma[k]) * s);
+			}
+
+			X D = 0;
+			for (size_t k = 0; k < K; ++k) {
+				X z = (x - c.mu[k]) / c.sigma[k] - c.sigma[k] * X(s);
+				X u = c.mu[k] + c.sigma[k] * c.sigma[k] * X(s);
+				D += X(q[k]) * ((u - X(k1)) * normal::cdf01(z) - c.sigma[k] * normal::cdf01(z, 1));
+			}
+
+			return D;
+		}
+
+		S cumulant(S s, size_t n = 0) const noexcept
+		{
+			S q[K];
+			S kappa = tilt(s, q);
+
+			if (n == 0) {
+				return kappa;
+			}
+			if (n >= BELL_MAX) {
+				return std::numeric_limits<S>::quiet_NaN();
+			}
+
+			// moments of the Esscher transform from components N(u_k, sigma_k^2)
+			// E[(u + sigma Z)^{j+1}] = u E[(u + sigma Z)^j] + j sigma^2 E[(u + sigma Z)^{j-1}]
+			S m[BELL_MAX] = { 1 }, m0[K], m1[K];
+			for (size_t k = 0; k < K; ++k) {
+				m0[k] = 1;
+				m1[k] = S(c.mu[k]) + S(c.sigma[k] * c.sigma[k]) * s;
+				m[1] += q[k] * m1[k];
+			}
+			for (size_t j = 1; j < n; ++j) {
+				S mj = 0;
+				for (size_t k = 0; k < K; ++k) {
+					S m2 = m1[k] * (S(c.mu[k]) + S(c.sigma[k] * c.sigma[k]) * s) + S(j) * S(c.sigma[k] * c.sigma[k]) * m0[k];
+					m0[k] = m1[k];
+					m1[k] = m2;
+					mj += q[k] * m2;
+				}
+				m[j + 1] = mj;
+			}
+
+			S kappa_[BELL_MAX];
+			cumulant_from_moment(n, m, kappa_);
+
+			return kappa_[n - 1];
+		}
+	};
+
+}
@@ -0,0 +1,78 @@
+// fms_variate_mixture.t.cpp - test normal mixture variate
+#include <cassert>
+#include <cmath>
+#include "fms_test.h"
+#include "fms_option.h"
+#include "fms_variate_mixture.h"
+
+using namespace fms;
+
+template<class X = double>
+int test_variate_mixture()
+{
+	X eps = std::numeric_limits<X>::epsilon();
+
+	{
+		// one component is standard normal
+		variate::mixture<X, X, 1> m({ 2 }, { 1 }, { 3 });
+		variate::normal_impl<X> n;
+
+		assert(m.weight(0) == 1 and m.mean(0) == 0 and m.stddev(0) == 1);
+		for (X x : {X(-2), X(0), X(0.5)}) {
+			for (X s : {X(0), X(0.1), X(1)}) {
+				assert(fabs(m.cdf(x, s) - n.cdf(x, s)) <= eps);
+				assert(fabs(m.cdf(x, s, 2) - n.cdf(x, s, 2)) <= eps);
+			}
+			assert(fabs(m.cumulant(x) - n.cumulant(x)) <= eps);
+			assert(fabs(m.cumulant(x, 1) - n.cumulant(x, 1)) <= 2 * eps);
+			assert(fabs(m.edf(x, X(0.2)) - n.edf(x, X(0.2))) <= 2 * eps);
+		}
+	}
+	{
+		variate::mixture<X, X, 3> m({ 0.2, 0.5, 0.3 }, { -1, 0, 0.5 }, { 1.5, 0.8, 1 });
+
+		assert(fabs(m.cumulant(0)) <= eps);
+		assert(fabs(m.cumulant(0, 1)) <= eps);
+		assert(fabs(m.cumulant(0, 2) - 1) <= 2 * eps);
+		assert(m.cumulant(0, 3) != 0); // skewed
+		assert(m.cdf(-10) < 1e-12);
+		assert(fabs(m.cdf(10, X(0.5)) - 1) < 1e-12);
+
+		test_variate(m, X(0.001));
+
+		// sizes are checked before the lists are read
+		bool thrown = false;
+		try {
+			variate::mixture<X, X, 3> m_({ 0.5, 0.5 }, { -1, 0, 0.5 }, { 1.5, 0.8, 1 });
+		}
+		catch (const std::exception&) {
+			thrown = true;
+		}
+		assert(thrown);
+
+		X s = X(0.3), h = X(1e-4);
+		for (size_t n : {0, 1, 2, 3, 4}) {
+			X dk = (m.cumulant(s + h, n) - m.cumulant(s - h, n)) / (2 * h);
+			assert(fabs(dk - m.cumulant(s, n + 1)) < 1e-6);
+		}
+		for (X s_ : {X(-0.5), X(0), X(0.3), X(1)}) {
+			assert(test_variate_edf(m, s_, X(-4), X(4), X(0.25)) < 1e-8);
+		}
+
+		option o(m);
+		X f = 100;
+		for (X k : {X(80), X(100), X(120)}) {
+			X c = o.value(f, X(0.2), payoff::call(k));
+			X p = o.value(f, X(0.2), payoff::put(k));
+			assert(fabs(c - p - (f - k)) < 1e-12);
+
+			// vega is the vol derivative of value
+			X h_ = X(1e-5);
+			X dv = (o.value(f, X(0.2) + h_, k) - o.value(f, X(0.2) - h_, k)) / (2 * h_);
+			assert(fabs(o.vega(f, X(0.2), k) - dv) < 1e-6);
+		}
+	}
+
+	return 0;
+}
+int test_variate_mixture_d = test_variate_mixture<double>();
@@ -21,8 +21,16 @@ namespace fms::variate {
 		normal_impl& operator=(const normal_impl&) = default;
 		normal_impl(normal_impl&&) = default;
 		normal_impl& operator=(normal_impl&&) = default;
-		~normal_impl()
-		{ }
+		~normal_impl() = default;
+
+		X mean() const noexcept
+		{
+			return mu;
+		}
+		X stdev() const noexcept
+		{
+			return sigma;
+		}
 
 		// Normal mean 0 variance 1
 		static X cdf01(X x, size_t n = 0) noexcept
@@ -41,6 +49,12 @@ namespace fms::variate {
 			return cdf01(((x - mu) / sigma) - s, n)/::pow(sigma,X(n));
 		}
 
+		// (d/ds) cdf(x, s, 0)
+		X edf(X x, S s) const noexcept
+		{
+			return -cdf01(((x - mu) / sigma) - s, 1);
+		}
+
 		static S cumulant01(S s, size_t n = 0)
 		{
 			if (n == 0) {
@@ -74,18 +88,33 @@ namespace fms::variate {
 
 			return 0;
 		}
-	private:
+
 		// Hermite polynomials H_0(x) = 1, H_1(x) = x, H_{n+1}(x) = x H_n(x) - n H_{n-1}(x)
 		static constexpr X H(size_t n, X x) noexcept
 		{
+			X h0 = 1, h1 = x;
+
 			if (n == 0) {
-				return X(1);
+				return h0;
 			}
-			if (n == 1) {
-				return x;
+			for (size_t j = 1; j < n; ++j) {
+				X h2 = x * h1 - X(j) * h0;
+				h0 = h1;
+				h1 = h2;
 			}
 
-			return x * H(n - 1, x) - X(n - 1) * H(n - 2, x);
+			return h1;
+		}
+		// H_0(x), ..., H_n(x) in h
+		static constexpr void H(size_t n, X x, X* h) noexcept
+		{
+			h[0] = 1;
+			if (n > 0) {
+				h[1] = x;
+			}
+			for (size_t j = 1; j < n; ++j) {
+				h[j + 1] = x * h[j] - X(j) * h[j - 1];
+			}
 		}
 	};
 
@@ -0,0 +1,166 @@
+// fms_versioned.h - owning versioned model handle with epoch based reclamation
+// Writers publish a new model snapshot with one atomic pointer swap.
+// Readers pin the current epoch in their own slot and never lock or block.
+// A replaced snapshot is deleted only after every reader that could see it has moved on.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "fms_ensure.h"
+
+namespace fms {
+
+	// R is the maximum number of concurrent readers
+	template<class M, size_t R = 64>
+	class versioned {
+		struct node {
+			M m;
+			uint64_t version;
+			uint64_t retired; // epoch after which no new reader can see this node
+		};
+		// epoch 0 means not reading
+		struct alignas(64) slot {
+			std::atomic<uint64_t> epoch{ 0 };
+			std::atomic<bool> used{ false };
+		};
+
+		std::atomic<node*> current;
+		std::atomic<uint64_t> epoch;
+		slot slots[R];
+		std::mutex writer; // serializes writers, never taken by readers
+		std::vector<node*> retired;
+		std::atomic<uint64_t> version_; // of current, read without pinning a node
+
+		// delete retired nodes no active reader can hold
+		void collect_()
+		{
+			uint64_t min = UINT64_MAX;
+			for (auto& s : slots) {
+				uint64_t e = s.epoch.load();
+				if (e != 0 and e < min) {
+					min = e;
+				}
+			}
+
+			auto i = std::partition(retired.begin(), retired.end(), [min](const node* n) { return n->retired > min; });
+			for (auto j = i; j != retired.end(); ++j) {
+				delete *j;
+			}
+			retired.erase(i, retired.end());
+		}
+	public:
+		typedef M model_type;
+
+		versioned(M m = M{})
+			: current(new node{ std::move(m), 1, 0 }), epoch(1), version_(1)
+		{ }
+		versioned(const versioned&) = delete;
+		versioned& operator=(const versioned&) = delete;
+		~versioned()
+		{
+			for (auto n : retired) {
+				delete n;
+			}
+			delete current.load();
+		}
+
+		// Pinned view of one model version. Keep it short lived.
+		class snapshot {
+			slot* s;
+			const node* n;
+		public:
+			snapshot(slot* s, const node* n)
+				: s(s), n(n)
+			{ }
+			snapshot(const snapshot&) = delete;
+			snapshot& operator=(const snapshot&) = delete;
+			~snapshot()
+			{
+				s->epoch.store(0, std::memory_order_release);
+			}
+
+			const M& operator*() const noexcept
+			{
+				return n->m;
+			}
+			const M* operator->() const noexcept
+			{
+				return &n->m;
+			}
+			uint64_t version() const noexcept
+			{
+				return n->version;
+			}
+		};
+
+		// One per pricing thread. Owns a slot for the lifetime of the reader.
+		class reader {
+			versioned* h;
+			slot* s;
+		public:
+			reader(versioned& h)
+				: h(&h), s(nullptr)
+			{
+				for (auto& s_ : h.slots) {
+					bool used = false;
+					if (s_.used.compare_exchange_strong(used, true)) {
+						s = &s_;
+						break;
+					}
+				}
+				ensure(s || !"versioned: no free reader slot");
+			}
+			reader(const reader&) = delete;
+			reader& operator=(const reader&) = delete;
+			~reader()
+			{
+				s->epoch.store(0);
+				s->used.store(false);
+			}
+
+			// wait free: announce the epoch then load the current node
+			snapshot read() const
+			{
+				ensure(s->epoch.load(std::memory_order_relaxed) == 0 || !"versioned: nested read");
+				s->epoch.store(h->epoch.load());
+
+				return snapshot(s, h->current.load());
+			}
+		};
+
+		// Replace the model. Readers holding a snapshot keep the old one.
+		uint64_t publish(M m)
+		{
+			std::lock_guard<std::mutex> lock(writer);
+
+			uint64_t v = version_.load() + 1;
+			node* n = new node{ std::move(m), v, 0 };
+			node* old = current.exchange(n);
+			version_.store(v);
+			old->retired = epoch.fetch_add(1) + 1;
+			retired.push_back(old);
+			collect_();
+
+			return v;
+		}
+
+		// Reclaim snapshots released since the last publish.
+		size_t collect()
+		{
+			std::lock_guard<std::mutex> lock(writer);
+
+			collect_();
+
+			return retired.size();
+		}
+
+		uint64_t version() const noexcept
+		{
+			return version_.load();
+		}
+	};
+
+}
@@ -0,0 +1,68 @@
+// fms_versioned.t.cpp - test versioned model handle
+#include <cassert>
+#include <thread>
+#include <vector>
+#include "fms_option.h"
+#include "fms_variate_discrete.h"
+#include "fms_versioned.h"
+
+using namespace fms;
+
+template<class X = double>
+int test_versioned()
+{
+	using model = variate::discrete<X, X, 2>;
+	using reader = typename versioned<model>::reader;
+
+	{
+		versioned<model> h(model({ -1, 1 }, { 0.5, 0.5 }));
+		assert(h.version() == 1);
+
+		reader r(h);
+		{
+			auto m = r.read();
+			assert(m.version() == 1);
+			assert(m->cdf(0) == X(0.5));
+
+			// old snapshot stays valid while pinned
+			assert(h.publish(model({ -1, 1 }, { 0.25, 0.75 })) == 2);
+			assert(m->cdf(0) == X(0.5));
+			assert(h.collect() == 1);
+		}
+		assert(h.collect() == 0);
+
+		auto m = r.read();
+		assert(m.version() == 2);
+		assert(m->cdf(0) == X(0.25));
+	}
+	{
+		versioned<model> h(model({ -1, 1 }, { 0.5, 0.5 }));
+		std::vector<std::thread> t;
+
+		for (int i = 0; i < 4; ++i) {
+			t.emplace_back([&h]() {
+				reader r(h);
+				uint64_t v = 0;
+				while (v < 100) {
+					auto m = r.read();
+					ensure(m.version() >= v);
+					v = m.version();
+					option o(*m);
+					X c = o.value(X(100), X(0.2), X(100));
+					ensure(X(0) < c and c < X(100));
+				}
+			});
+		}
+		for (int i = 0; i < 99; ++i) {
+			X p = X(0.25) + X(i % 2) / 4;
+			h.publish(model({ -1, 1 }, { p, 1 - p }));
+		}
+		for (auto& t_ : t) {
+			t_.join();
+		}
+		assert(h.collect() == 0);
+	}
+
+	return 0;
+}
+int test_versioned_d = test_versioned<double>();
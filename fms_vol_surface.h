@@ -0,0 +1,161 @@
+// fms_vol_surface.h - vol on an expiry by log moneyness grid
+// Nodes are z = log(k/f) at each expiry since option::moneyness depends on s itself.
+// Vols are s = sigma sqrt(t), the parameter fms::option uses, stored as
+// total variance s^2 in one row major array. Interpolation is linear in z
+// and linear in total variance across expiries with flat extrapolation in
+// z and in sigma before the first and after the last expiry.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "fms_ensure.h"
+#include "fms_option.h"
+
+namespace fms {
+
+	template<class X = double>
+	class vol_surface {
+		std::vector<X> t; // expiries
+		std::vector<X> f; // forward at each expiry
+		std::vector<X> z; // log moneyness nodes
+		std::vector<X> w; // total variance w[i * z.size() + j] at t[i], z[j]
+
+		// largest i with x[i] <= x_ starting from i, or 0
+		static size_t hunt(const std::vector<X>& x, X x_, size_t i) noexcept
+		{
+			if (i >= x.size()) {
+				i = 0;
+			}
+			while (i > 0 and x_ < x[i]) {
+				--i;
+			}
+			while (i + 1 < x.size() and x[i + 1] <= x_) {
+				++i;
+			}
+
+			return i;
+		}
+
+		// total variance at expiry index i and log moneyness z_
+		X variance(size_t i, X z_, size_t j) const noexcept
+		{
+			const X* wi = w.data() + i * z.size();
+
+			if (z_ <= z.front()) {
+				return wi[0];
+			}
+			if (z_ >= z.back()) {
+				return wi[z.size() - 1];
+			}
+
+			X u = (z_ - z[j]) / (z[j + 1] - z[j]);
+
+			return wi[j] + u * (wi[j + 1] - wi[j]);
+		}
+	public:
+		// Last expiry and strike node used. Reuse for O(1) nearby lookups.
+		struct cursor {
+			size_t i = 0, j = 0;
+		};
+
+		vol_surface()
+		{ }
+		// m expiries t with forwards f, n log moneyness nodes z, and m x n vols s
+		vol_surface(size_t m, const X* t, const X* f, size_t n, const X* z, const X* s)
+			: t(t, t + m), f(f, f + m), z(z, z + n), w(s, s + m * n)
+		{
+			ensure(m > 0 and n > 0);
+			ensure(std::is_sorted(this->t.begin(), this->t.end()));
+			ensure(std::is_sorted(this->z.begin(), this->z.end()));
+			ensure(this->t.front() > 0);
+
+			for (auto& w_ : w) {
+				ensure(w_ >= 0);
+				w_ *= w_;
+			}
+		}
+		vol_surface(const vol_surface&) = default;
+		vol_surface& operator=(const vol_surface&) = default;
+		~vol_surface()
+		{ }
+
+		size_t expiries() const noexcept
+		{
+			return t.size();
+		}
+		size_t strikes() const noexcept
+		{
+			return z.size();
+		}
+
+		// log linear in expiry, flat outside the grid
+		X forward(X t_, cursor& c) const noexcept
+		{
+			if (t_ <= t.front()) {
+				return f.front();
+			}
+			if (t_ >= t.back()) {
+				return f.back();
+			}
+
+			size_t i = c.i = hunt(t, t_, c.i);
+			X u = (t_ - t[i]) / (t[i + 1] - t[i]);
+
+			return f[i] * ::pow(f[i + 1] / f[i], u);
+		}
+		X forward(X t_) const noexcept
+		{
+			cursor c;
+
+			return forward(t_, c);
+		}
+
+		// vol s at expiry t_ and strike k, negative for put
+		X vol(X t_, X k, cursor& c) const
+		{
+			ensure(t_ > 0);
+
+			k = ::fabs(k);
+			ensure(k > 0);
+
+			size_t i = c.i = hunt(t, t_, c.i);
+
+			// log moneyness uses the forward at t_
+			X z_ = ::log(k / forward(t_, c));
+			size_t j = c.j = hunt(z, z_, c.j);
+
+			if (t_ <= t.front()) {
+				return ::sqrt(variance(0, z_, j) * t_ / t.front());
+			}
+			if (t_ >= t.back()) {
+				return ::sqrt(variance(t.size() - 1, z_, j) * t_ / t.back());
+			}
+
+			X w0 = variance(i, z_, j);
+			X w1 = variance(i + 1, z_, j);
+			X u = (t_ - t[i]) / (t[i + 1] - t[i]);
+
+			return ::sqrt(w0 + u * (w1 - w0));
+		}
+		X vol(X t_, X k) const
+		{
+			cursor c;
+
+			return vol(t_, k, c);
+		}
+
+		// Value n options with expiry t_ and strike k, negative for put.
+		// Sorting by expiry then strike makes each lookup O(1).
+		template<class M>
+		void value(const option<M>& o, size_t n, const X* t_, const X* k, X* v) const
+		{
+			cursor c;
+
+			for (size_t i = 0; i < n; ++i) {
+				X s = vol(t_[i], k[i], c);
+				v[i] = o.value(forward(t_[i], c), s, k[i]);
+			}
+		}
+	};
+
+}
@@ -0,0 +1,66 @@
+// fms_vol_surface.t.cpp - test vol surface
+#include <cassert>
+#include <cmath>
+#include "fms_variate_normal.h"
+#include "fms_vol_surface.h"
+
+using namespace fms;
+
+template<class X = double>
+int test_vol_surface()
+{
+	X eps = 10 * std::numeric_limits<X>::epsilon();
+	X t[] = { X(0.25), X(0.5), X(1) };
+	X f[] = { 100, 101, 103 };
+	X z[] = { X(-0.2), X(0), X(0.2) };
+	X sigma[] = { X(0.3), X(0.2), X(0.25) }; // smile
+
+	X s[9];
+	for (size_t i = 0; i < 3; ++i) {
+		for (size_t j = 0; j < 3; ++j) {
+			s[i * 3 + j] = sigma[j] * ::sqrt(t[i]);
+		}
+	}
+	vol_surface<X> vs(3, t, f, 3, z, s);
+
+	{
+		assert(vs.expiries() == 3 and vs.strikes() == 3);
+		assert(vs.forward(X(0.5)) == 101);
+		assert(vs.forward(X(0.1)) == 100);
+		assert(fabs(vs.forward(X(0.75)) - ::sqrt(X(101 * 103))) < 100 * eps);
+	}
+	{
+		// nodes are exact, puts and calls share a vol
+		for (size_t i = 0; i < 3; ++i) {
+			for (size_t j = 0; j < 3; ++j) {
+				X k = f[i] * ::exp(z[j]);
+				assert(fabs(vs.vol(t[i], k) - s[i * 3 + j]) < eps);
+				assert(vs.vol(t[i], k) == vs.vol(t[i], -k));
+			}
+		}
+		// linear in total variance across expiries
+		X sigma_ = vs.vol(X(0.75), vs.forward(X(0.75))) / ::sqrt(X(0.75));
+		assert(fabs(sigma_ - X(0.2)) < eps);
+		// flat in sigma outside expiries and in z outside strikes
+		assert(fabs(vs.vol(X(2), 103) / ::sqrt(X(2)) - X(0.2)) < eps);
+		assert(fabs(vs.vol(X(0.5), 1000) / ::sqrt(X(0.5)) - X(0.25)) < eps);
+		assert(fabs(vs.vol(X(0.5), 1) / ::sqrt(X(0.5)) - X(0.3)) < eps);
+	}
+	{
+		// batch value with a cursor
+		variate::normal_impl<X> N;
+		option o(N);
+
+		X t_[] = { X(0.3), X(0.3), X(0.3), X(0.8), X(0.8) };
+		X k_[] = { -90, 100, 110, -95, 105 };
+		X v[5];
+		vs.value(o, 5, t_, k_, v);
+		for (size_t i = 0; i < 5; ++i) {
+			X v_ = o.value(vs.forward(t_[i]), vs.vol(t_[i], k_[i]), k_[i]);
+			assert(v[i] == v_);
+		}
+	}
+
+	return 0;
+}
+int test_vol_surface_d = test_vol_surface<double>();